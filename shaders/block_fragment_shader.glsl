@@ -1,25 +1,30 @@
 #version 330 core
 out vec4 FragColor;
 
-in vec3 ourColor;
 in vec2 TexCoord;
+flat in float TextureLayer; // ブロックの種類と面の向きで決まるテクスチャ配列のレイヤー
 in vec3 Normal;
 in float AO; // <--- 頂点シェーダーから受け取るAO値
 in vec3 FragPosCameraSpace; // <--- カメラ空間でのフラグメント位置
 
-uniform sampler2D ourTexture;
-uniform vec3 lightDir;
-uniform float ambientStrength;
+uniform sampler2DArray ourTexture;
 
-// フォグ用のuniform変数
-uniform vec3 fogColor;
-uniform float fogStart;
-uniform float fogEnd;
-uniform float fogDensity; // 指数関数的フォグ用
+// フレーム中は変わらない値 (Renderer::FrameUniforms と同じ並び)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    vec3 fogColor;
+    float fogStart;
+    vec3 lightDir;
+    float fogEnd;
+    float fogDensity; // 指数関数的フォグ用
+    float ambientStrength;
+};
 
 void main()
 {
-    vec3 texColor = texture(ourTexture, TexCoord).rgb;
+    vec3 texColor = texture(ourTexture, vec3(TexCoord, TextureLayer)).rgb;
 
     // AO値を0-1の範囲に正規化し、環境光に適用
     // AO値が0の場合は最も暗く、3の場合は最も明るい (1.0) になるように調整
@@ -1,32 +1,57 @@
 #version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aColor; // 既存の色属性 (使用しない場合でも互換性のため残す)
-layout (location = 2) in vec2 aTexCoord; // テクスチャ座標属性
-layout (location = 3) in vec3 aNormal; // 法線属性
-layout (location = 4) in float aAO; // <--- AO属性を追加
+// パック済み頂点 (mesh_types.hpp の Vertex を参照)
+//   x: 位置 x | y << 7 | z << 14 | 面番号 << 21 | AO << 24
+//   y: テクスチャ座標 u | v << 7 (タイル単位) | テクスチャ配列のレイヤー << 14
+layout (location = 0) in uvec2 aPacked;
+// チャンクのワールド座標での原点 (描画コマンドごとのインスタンス属性、または描画ごとの定数)
+layout (location = 1) in ivec3 aChunkOrigin;
 
-out vec3 ourColor;
 out vec2 TexCoord;
+flat out float TextureLayer;
 out vec3 Normal;
 out float AO; // <--- フラグメントシェーダーへ渡すAO値
 out vec3 FragPosCameraSpace; // <--- カメラ空間でのフラグメント位置を追加
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-uniform mat3 normalMatrix;
+// フレーム中は変わらない値 (Renderer::FrameUniforms と同じ並び)
+layout (std140) uniform FrameUniforms
+{
+    mat4 view;
+    mat4 projection;
+    vec3 fogColor;
+    float fogStart;
+    vec3 lightDir;
+    float fogEnd;
+    float fogDensity;
+    float ambientStrength;
+};
+
+// 面番号ごとの法線 (face_baker.cpp の faceNormals と同じ順序)
+const vec3 FACE_NORMALS[6] = vec3[6](
+    vec3(0.0, 0.0, -1.0), // 0: Back face (Z-)
+    vec3(0.0, 0.0, 1.0),  // 1: Front face (Z+)
+    vec3(-1.0, 0.0, 0.0), // 2: Left face (X-)
+    vec3(1.0, 0.0, 0.0),  // 3: Right face (X+)
+    vec3(0.0, -1.0, 0.0), // 4: Bottom face (Y-)
+    vec3(0.0, 1.0, 0.0)   // 5: Top face (Y+)
+);
 
 void main()
 {
-    vec4 worldPos = model * vec4(aPos, 1.0);
+    uint position = aPacked.x;
+    vec3 aPos = vec3(float(position & 127u),
+                     float((position >> 7u) & 127u),
+                     float((position >> 14u) & 127u));
+    uint faceIndex = (position >> 21u) & 7u;
+
+    vec4 worldPos = vec4(aPos + vec3(aChunkOrigin), 1.0);
     gl_Position = projection * view * worldPos;
     
     // カメラ空間での位置を計算し、フラグメントシェーダーに渡す
     // フォグの計算には、カメラからの距離が必要なので、カメラ空間での位置が便利
     FragPosCameraSpace = vec3(view * worldPos); 
 
-    ourColor = aColor;
-    TexCoord = aTexCoord;
-    Normal = normalize(normalMatrix * aNormal);
-    AO = aAO; // <--- AO値をそのまま出力
+    TexCoord = vec2(float(aPacked.y & 127u), float((aPacked.y >> 7u) & 127u));
+    TextureLayer = float((aPacked.y >> 14u) & 255u);
+    Normal = FACE_NORMALS[faceIndex]; // チャンクは平行移動だけなので、法線はそのまま使える
+    AO = float((position >> 24u) & 3u);
 }
@@ -1,4 +1,5 @@
 #include "TextRenderer.hpp"
+#include "gl_state_cache.hpp"
 #include <iostream>
 #include <vector>
 #include <glm/gtc/matrix_transform.hpp> // for glm::ortho
@@ -111,7 +112,8 @@ GLuint createTextShaderProgram(const std::string &vertexPath, const std::string
 
 // コンストラクタ
 TextRenderer::TextRenderer()
-    : m_textVAO(0), m_textVBO(0), m_textShaderProgram(0), m_fontData(nullptr)
+    : m_textVAO(0), m_textVBO(0), m_textShaderProgram(0), m_fontData(nullptr),
+      m_projectionLoc(-1), m_textColorLoc(-1)
 {
 }
 
@@ -140,6 +142,13 @@ bool TextRenderer::initialize(const std::string &textShaderVertPath, const std::
         return false;
     }
 
+    // uniform ロケーションを取得し、フレーム中に変わらないテクスチャユニットはここで設定しておく
+    m_projectionLoc = glGetUniformLocation(m_textShaderProgram, "projection");
+    m_textColorLoc = glGetUniformLocation(m_textShaderProgram, "textColor");
+    glUseProgram(m_textShaderProgram);
+    glUniform1i(glGetUniformLocation(m_textShaderProgram, "fontAtlas"), 0); // テクスチャユニット0
+    glUseProgram(0);
+
     // VAOとVBOのセットアップ
     glGenVertexArrays(1, &m_textVAO);
     glGenBuffers(1, &m_textVBO);
@@ -170,21 +179,20 @@ void TextRenderer::renderText(const std::string &text, float x, float y, float s
         return;
     }
 
-    glUseProgram(m_textShaderProgram);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_fontData->textureID);
-    glUniform1i(glGetUniformLocation(m_textShaderProgram, "fontAtlas"), 0); // テクスチャユニット0
+    GlStateCache::useProgram(m_textShaderProgram);
+    GlStateCache::bindTexture2D(m_fontData->textureID);
 
-    glUniformMatrix4fv(glGetUniformLocation(m_textShaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glUniform3fv(glGetUniformLocation(m_textShaderProgram, "textColor"), 1, glm::value_ptr(color));
+    glUniformMatrix4fv(m_projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform3fv(m_textColorLoc, 1, glm::value_ptr(color));
     // ここでoutlineColor, outlineWidthなどをuniformで設定することも可能
 
     glBindVertexArray(m_textVAO);
 
     // ブレンディングを有効化 (テキストの透明な部分を描画しないため)
-    glEnable(GL_BLEND);
+    // 深度テストとブレンドは元に戻さない (3D の描画側が必要な状態を設定する。同じ状態なら GL は呼ばれない)
+    GlStateCache::setEnabled(GL_BLEND, true);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDisable(GL_DEPTH_TEST); // テキストは2Dオーバーレイなので深度テストは不要
+    GlStateCache::setEnabled(GL_DEPTH_TEST, false); // テキストは2Dオーバーレイなので深度テストは不要
 
     float currentX = x; // 現在のX座標
     float currentY = y; // 現在のY座標
@@ -270,6 +278,4 @@ void TextRenderer::renderText(const std::string &text, float x, float y, float s
     // クリーンアップ
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST); // 深度テストを元に戻す
 }
\ No newline at end of file
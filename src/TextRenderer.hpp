@@ -16,6 +16,8 @@ public:
 private:
     GLuint m_textVAO, m_textVBO, m_textShaderProgram;
     const FontData *m_fontData;
+    // uniform ロケーション (initialize で一度だけ取得する)
+    GLint m_projectionLoc, m_textColorLoc;
 };
 
 #endif // TEXT_RENDERER_HPP
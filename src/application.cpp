@@ -29,10 +29,17 @@ Application::Application()
       m_fogEnd(RENDER_DISTANCE_CHUNKS * CHUNK_GRID_SIZE * 1.0f),   // 例: 描画距離の終端で完全にフォグ
       m_fogDensity(0.005f)                                         // 指数関数的フォグの密度 (小さいほど遠くまで見える)
 {
+    MeshingOptions meshingOptions;
+    meshingOptions.mode = CHUNK_MESHING_MODE;
+    meshingOptions.randomTextureVariants = RANDOM_TEXTURE_VARIANTS;
+    m_chunkManager->setMeshingOptions(meshingOptions);
 }
 
 Application::~Application()
 {
+    // GPU リソースはコンテキストが有効なうちに解放する
+    m_chunkManager.reset();
+    ChunkRenderer::releaseSharedBuffers();
     glfwTerminate();
 }
 
@@ -62,14 +69,15 @@ bool Application::initialize()
         return false;
     }
 
-    m_chunkManager->update(m_camera->getPosition());
-
     setupCallbacks();
 
     int initialWidth, initialHeight;
     glfwGetFramebufferSize(m_windowContext->getWindow(), &initialWidth, &initialHeight);
     updateProjectionMatrix(initialWidth, initialHeight);
 
+    updateFrustum();
+    m_chunkManager->update(m_camera->getPosition(), m_frustum, 0.0f);
+
     return true;
 }
 
@@ -77,9 +85,11 @@ void Application::run()
 {
     while (!m_windowContext->shouldClose())
     {
+        double frameStartTime = glfwGetTime();
         processInput();
         update();
         render();
+        m_lastFrameWorkSeconds = static_cast<float>(glfwGetTime() - frameStartTime);
         m_windowContext->swapBuffers();
         m_windowContext->pollEvents();
     }
@@ -113,7 +123,9 @@ void Application::update()
 {
     m_timer->tick();
     updateFpsAndPositionStrings();
-    m_chunkManager->update(m_camera->getPosition());
+    // 視錐台はチャンクジョブの優先度と描画時のカリングの両方で使う
+    updateFrustum();
+    m_chunkManager->update(m_camera->getPosition(), m_frustum, m_lastFrameWorkSeconds);
 }
 
 void Application::updateFpsAndPositionStrings()
@@ -137,80 +149,30 @@ void Application::updateFpsAndPositionStrings()
     m_positionString = ss.str();
 }
 
-void Application::extractFrustumPlanes(const glm::mat4 &viewProjection)
+// 現在のカメラと投影行列から視錐台を更新する
+void Application::updateFrustum()
 {
-    m_frustumPlanes[0].normal = glm::vec3(viewProjection[0][3] - viewProjection[0][0],
-                                          viewProjection[1][3] - viewProjection[1][0],
-                                          viewProjection[2][3] - viewProjection[2][0]);
-    m_frustumPlanes[0].distance = viewProjection[3][3] - viewProjection[3][0];
-
-    m_frustumPlanes[1].normal = glm::vec3(viewProjection[0][3] + viewProjection[0][0],
-                                          viewProjection[1][3] + viewProjection[1][0],
-                                          viewProjection[2][3] + viewProjection[2][0]);
-    m_frustumPlanes[1].distance = viewProjection[3][3] + viewProjection[3][0];
-
-    m_frustumPlanes[2].normal = glm::vec3(viewProjection[0][3] + viewProjection[0][1],
-                                          viewProjection[1][3] + viewProjection[1][1],
-                                          viewProjection[2][3] + viewProjection[2][1]);
-    m_frustumPlanes[2].distance = viewProjection[3][3] + viewProjection[3][1];
-
-    m_frustumPlanes[3].normal = glm::vec3(viewProjection[0][3] - viewProjection[0][1],
-                                          viewProjection[1][3] - viewProjection[1][1],
-                                          viewProjection[2][3] - viewProjection[2][1]);
-    m_frustumPlanes[3].distance = viewProjection[3][3] - viewProjection[3][1];
-
-    m_frustumPlanes[4].normal = glm::vec3(viewProjection[0][3] - viewProjection[0][2],
-                                          viewProjection[1][3] - viewProjection[1][2],
-                                          viewProjection[2][3] - viewProjection[2][2]);
-    m_frustumPlanes[4].distance = viewProjection[3][3] - viewProjection[3][2];
-
-    m_frustumPlanes[5].normal = glm::vec3(viewProjection[0][3] + viewProjection[0][2],
-                                          viewProjection[1][3] + viewProjection[1][2],
-                                          viewProjection[2][3] + viewProjection[2][2]);
-    m_frustumPlanes[5].distance = viewProjection[3][3] + viewProjection[3][2];
-
-    for (int i = 0; i < 6; ++i)
-    {
-        float length = glm::length(m_frustumPlanes[i].normal);
-        m_frustumPlanes[i].normal /= length;
-        m_frustumPlanes[i].distance /= length;
-    }
+    m_frustum.update(m_projectionMatrix * m_camera->getViewMatrix());
 }
 
-bool Application::isChunkInFrustum(const glm::ivec3 &chunkCoord) const
+// 向き i の面はメッシュの AABB 内のどこかの平面上にあるので、カメラが AABB の
+// 裏側の半空間に完全に入っている場合、その向きの面は全て裏向きになる
+// (例: X+ 向きの面はカメラの x が AABB の最小 x 以下なら見えない)
+unsigned int Application::getVisibleFaceMask(const glm::ivec3 &chunkCoord, const ChunkRenderData &renderData,
+                                             const glm::vec3 &cameraPosition) const
 {
-    glm::vec3 minPoint = static_cast<glm::vec3>(chunkCoord * CHUNK_GRID_SIZE);
-    glm::vec3 maxPoint = static_cast<glm::vec3>((chunkCoord + glm::ivec3(1)) * CHUNK_GRID_SIZE);
-
-    for (int i = 0; i < 6; ++i)
-    {
-        const Plane &p = m_frustumPlanes[i];
-
-        glm::vec3 p_vertex = minPoint;
-        glm::vec3 n_vertex = maxPoint;
-
-        if (p.normal.x >= 0)
-        {
-            p_vertex.x = maxPoint.x;
-            n_vertex.x = minPoint.x;
-        }
-        if (p.normal.y >= 0)
-        {
-            p_vertex.y = maxPoint.y;
-            n_vertex.y = minPoint.y;
-        }
-        if (p.normal.z >= 0)
-        {
-            p_vertex.z = maxPoint.z;
-            n_vertex.z = minPoint.z;
-        }
-
-        if (glm::dot(p.normal, p_vertex) + p.distance < 0)
-        {
-            return false;
-        }
-    }
-    return true;
+    glm::vec3 minPoint = static_cast<glm::vec3>(chunkCoord * CHUNK_GRID_SIZE + renderData.boundsMin);
+    glm::vec3 maxPoint = static_cast<glm::vec3>(chunkCoord * CHUNK_GRID_SIZE + renderData.boundsMax);
+
+    unsigned int mask = 0;
+    // 面の順序: Z-, Z+, X-, X+, Y-, Y+
+    if (cameraPosition.z < maxPoint.z) mask |= 1u << 0;
+    if (cameraPosition.z > minPoint.z) mask |= 1u << 1;
+    if (cameraPosition.x < maxPoint.x) mask |= 1u << 2;
+    if (cameraPosition.x > minPoint.x) mask |= 1u << 3;
+    if (cameraPosition.y < maxPoint.y) mask |= 1u << 4;
+    if (cameraPosition.y > minPoint.y) mask |= 1u << 5;
+    return mask;
 }
 
 void Application::render()
@@ -225,29 +187,21 @@ void Application::render()
         glm::vec4(CLEAR_COLOR_R, CLEAR_COLOR_G, CLEAR_COLOR_B, CLEAR_COLOR_A));
 
     glm::mat4 view = m_camera->getViewMatrix();
-    glm::mat4 viewProjection = m_projectionMatrix * view;
-
-    extractFrustumPlanes(viewProjection);
 
     // フォグのuniform変数をレンダラーに渡す
     m_renderer->setFogParameters(m_fogColor, m_fogStart, m_fogEnd, m_fogDensity);
 
-    const auto &allRenderData = m_chunkManager->getAllRenderData();
-    for (const auto &pair : allRenderData)
-    {
-        glm::ivec3 chunkCoord = pair.first;
-        const ChunkRenderData &renderData = pair.second;
-
-        if (!isChunkInFrustum(chunkCoord))
+    // 視錐台と交差するチャンクを集めて、まとめて描画する
+    const glm::vec3 cameraPosition = m_camera->getPosition();
+    m_chunkDrawItems.clear();
+    m_chunkManager->forEachVisibleRenderData(
+        m_frustum,
+        [&](const glm::ivec3 &chunkCoord, const ChunkRenderData &renderData)
         {
-            continue;
-        }
-
-        glm::mat4 model = glm::translate(glm::mat4(1.0f),
-                                         static_cast<glm::vec3>(chunkCoord * CHUNK_GRID_SIZE));
-
-        m_renderer->renderScene(m_projectionMatrix, view, renderData, model);
-    }
+            m_chunkDrawItems.push_back({chunkCoord * CHUNK_GRID_SIZE, &renderData,
+                                        getVisibleFaceMask(chunkCoord, renderData, cameraPosition)});
+        });
+    m_renderer->renderChunks(m_projectionMatrix, view, m_chunkDrawItems);
 
     int w, h;
     glfwGetFramebufferSize(m_windowContext->getWindow(), &w, &h);
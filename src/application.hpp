@@ -4,6 +4,7 @@
 #include <array>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -12,18 +13,12 @@
 #include "TextRenderer.hpp"
 #include "camera.hpp"
 #include "chunk_manager.hpp"
+#include "frustum.hpp"
 #include "input_manager.hpp"
 #include "renderer.hpp"
 #include "time/timer.hpp"
 #include "window_context.hpp"
 
-// Represents a plane in the form Ax + By + Cz + D = 0
-struct Plane
-{
-    glm::vec3 normal;
-    float distance; // Distance from origin
-};
-
 class Application
 {
 public:
@@ -66,9 +61,16 @@ private:
     static constexpr int TERRAIN_OCTAVES = 4;
     static constexpr float TERRAIN_LACUNARITY = 2.0f;
     static constexpr float TERRAIN_PERSISTENCE = 0.5f;
+    static constexpr MeshingMode CHUNK_MESHING_MODE = MeshingMode::Greedy;
+    static constexpr bool RANDOM_TEXTURE_VARIANTS = true; // false にすると Greedy で結合できる面が大きく増える (タイルの向きが揃い、見た目は変わる)
 
-    // Frustum culling planes
-    std::array<Plane, 6> m_frustumPlanes;
+    // Frustum culling (update() で毎フレーム更新する)
+    Frustum m_frustum;
+    // render() で描画するチャンクの一覧 (確保し直さないようフレーム間で使い回す)
+    std::vector<ChunkDrawItem> m_chunkDrawItems;
+    // 直前のフレームで CPU が作業していた時間 (フレームの開始から swapBuffers の直前まで)
+    // 垂直同期の待ちを含まないので、フレーム時間に対する余裕をチャンクの GPU 作業の予算に反映できる
+    float m_lastFrameWorkSeconds = 0.0f;
 
     // フォグ関連のパラメータ
     glm::vec3 m_fogColor;
@@ -86,8 +88,10 @@ private:
     void updateProjectionMatrix(int width, int height);
 
     // Frustum culling methods
-    void extractFrustumPlanes(const glm::mat4 &viewProjection);
-    bool isChunkInFrustum(const glm::ivec3 &chunkCoord) const;
+    void updateFrustum();
+    // チャンクのメッシュの AABB とカメラ位置から、カメラ側を向き得る面の向きのマスクを求める
+    unsigned int getVisibleFaceMask(const glm::ivec3 &chunkCoord, const ChunkRenderData &renderData,
+                                    const glm::vec3 &cameraPosition) const;
 };
 
 #endif // APPLICATION_HPP
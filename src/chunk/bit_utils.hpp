@@ -0,0 +1,42 @@
+#ifndef BIT_UTILS_HPP
+#define BIT_UTILS_HPP
+
+#include <cstdint>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// ボクセル列 (ビットマスク) を扱うための小さなビット演算ヘルパー
+namespace bits
+{
+    // 下位 count ビットが立ったマスクを返す (count は 0〜64)
+    inline std::uint64_t lowMask(int count)
+    {
+        return count >= 64 ? ~std::uint64_t(0) : ((std::uint64_t(1) << count) - 1);
+    }
+
+    // 立っているビットの数
+    inline int popcount(std::uint64_t v)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        return static_cast<int>(__popcnt64(v));
+#else
+        return __builtin_popcountll(v);
+#endif
+    }
+
+    // 最下位の立っているビットの位置 (v != 0 であること)
+    inline int countTrailingZeros(std::uint64_t v)
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long index;
+        _BitScanForward64(&index, v);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(v);
+#endif
+    }
+}
+
+#endif // BIT_UTILS_HPP
@@ -0,0 +1,42 @@
+#ifndef BLOCK_TYPES_HPP
+#define BLOCK_TYPES_HPP
+
+#include <cstdint>
+
+// ブロックの種類を表すID (0 は常に空気)
+using BlockId = std::uint16_t;
+
+constexpr BlockId BLOCK_AIR = 0;
+constexpr BlockId BLOCK_STONE = 1;
+constexpr BlockId BLOCK_DIRT = 2;
+constexpr BlockId BLOCK_GRASS = 3;
+
+// setVoxel(true) など、素材を指定せずにソリッドにした場合のブロック
+constexpr BlockId DEFAULT_SOLID_BLOCK = BLOCK_STONE;
+
+// ブロックの面に貼るテクスチャ (ブロック用テクスチャ配列のレイヤー番号)
+constexpr int TEXTURE_LAYER_STONE = 0;
+constexpr int TEXTURE_LAYER_DIRT = 1;
+constexpr int TEXTURE_LAYER_GRASS_TOP = 2;
+constexpr int TEXTURE_LAYER_GRASS_SIDE = 3;
+constexpr int BLOCK_TEXTURE_LAYER_COUNT = 4;
+
+// ブロックの面 (面番号は neighborOffsets / faceNormals と同じ: 4 が Y-、5 が Y+) のテクスチャのレイヤー
+inline int getBlockTextureLayer(BlockId id, int faceIndex)
+{
+    switch (id)
+    {
+    case BLOCK_DIRT:
+        return TEXTURE_LAYER_DIRT;
+    case BLOCK_GRASS:
+        if (faceIndex == 5)
+        {
+            return TEXTURE_LAYER_GRASS_TOP;
+        }
+        return faceIndex == 4 ? TEXTURE_LAYER_DIRT : TEXTURE_LAYER_GRASS_SIDE;
+    default:
+        return TEXTURE_LAYER_STONE;
+    }
+}
+
+#endif // BLOCK_TYPES_HPP
@@ -1,44 +1,335 @@
 #include "chunk.hpp"
+#include "bit_utils.hpp"
+#include <algorithm>
 #include <stdexcept>
 #include <glm/glm.hpp> // glm::ivec3 のために追加
 
+namespace
+{
+    // 境界の層のハッシュ。全て 0 (空気) の入力は必ず 0 になる
+    std::uint64_t hashBorderSlice(const Chunk::Column *words, int count)
+    {
+        std::uint64_t hash = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            hash = ((hash << 7) | (hash >> 57)) ^ words[i];
+            hash *= 0x9E3779B97F4A7C15ull;
+        }
+        return hash;
+    }
+}
+
 // コンストラクタにcoordパラメータを追加し、m_coordを初期化
-Chunk::Chunk(int size, const glm::ivec3& coord) 
-    : m_size(size), m_isDirty(true), m_coord(coord) // m_coord を初期化
+Chunk::Chunk(int size, const glm::ivec3& coord)
+    : m_uniformColumn(0), m_materials(static_cast<size_t>(size) * size * size, DEFAULT_SOLID_BLOCK), m_size(size), m_fullColumnMask(0),
+      m_columnSlotShift(3), m_columnsPerWordShift(3), m_columnInWordMask(7), m_isDirty(true), m_changeListener(nullptr), m_coord(coord), // m_coord を初期化
+      m_borderSignatures{}, m_borderSignaturesValid(false)
 {
     if (size <= 0)
     {
         throw std::invalid_argument("Chunk size must be positive.");
     }
-    m_voxels.resize(m_size * m_size * m_size);
+    if (size > MAX_SIZE)
+    {
+        throw std::invalid_argument("Chunk size must not exceed 62 (padded column must fit in one 64-bit word).");
+    }
+    m_fullColumnMask = bits::lowMask(m_size);
+
+    // 列スロット幅は size 以上の最小の 8/16/32/64 ビット
+    while ((1 << m_columnSlotShift) < m_size)
+    {
+        ++m_columnSlotShift;
+    }
+    m_columnsPerWordShift = 6 - m_columnSlotShift;
+    m_columnInWordMask = (size_t(1) << m_columnsPerWordShift) - 1;
+    // 列バッファは一様でなくなった時点で確保する
+}
+
+void Chunk::allocateColumns()
+{
+    // 一様な値を全スロットへ複製した状態で列バッファを確保する
+    std::uint64_t pattern = 0;
+    for (size_t i = 0; i <= m_columnInWordMask; ++i)
+    {
+        pattern |= m_uniformColumn << (i << m_columnSlotShift);
+    }
+    size_t columnCount = static_cast<size_t>(m_size) * m_size;
+    m_columnWords.assign((columnCount + m_columnInWordMask) >> m_columnsPerWordShift, pattern);
+}
+
+void Chunk::fill(BlockId id)
+{
+    m_columnWords.clear();
+    m_columnWords.shrink_to_fit();
+    m_uniformColumn = (id == BLOCK_AIR) ? 0 : m_fullColumnMask;
+    m_materials.fill(id == BLOCK_AIR ? DEFAULT_SOLID_BLOCK : id);
+    m_borderSignaturesValid = false;
+    setDirty(true);
+}
+
+void Chunk::setDirty(bool dirty)
+{
+    bool becameDirty = dirty && !m_isDirty;
+    m_isDirty = dirty;
+    if (becameDirty && m_changeListener)
+    {
+        m_changeListener->onChunkDirty(*this);
+    }
+}
+
+void Chunk::writeColumn(size_t columnIndex, Column mask)
+{
+    m_borderSignaturesValid = false;
+    if (m_columnWords.empty())
+    {
+        if (mask == m_uniformColumn)
+        {
+            return; // 一様なまま
+        }
+        allocateColumns();
+    }
+    int shift = static_cast<int>((columnIndex & m_columnInWordMask) << m_columnSlotShift);
+    std::uint64_t &word = m_columnWords[columnIndex >> m_columnsPerWordShift];
+    word = (word & ~(m_fullColumnMask << shift)) | ((mask & m_fullColumnMask) << shift);
 }
 
 void Chunk::setVoxel(int x, int y, int z, bool value)
 {
-    m_voxels[getIndex(x, y, z)] = value;
-    m_isDirty = true;
+    setBlock(x, y, z, value ? DEFAULT_SOLID_BLOCK : BLOCK_AIR);
+}
+
+BlockId Chunk::getBlock(int x, int y, int z) const
+{
+    checkBounds(x, y, z);
+    if (((getColumn(x, z) >> y) & 1) == 0)
+    {
+        return BLOCK_AIR;
+    }
+    return m_materials.get(getMaterialIndex(x, y, z));
+}
+
+void Chunk::setBlock(int x, int y, int z, BlockId id)
+{
+    checkBounds(x, y, z);
+    size_t columnIndex = getColumnIndex(x, z);
+    const Column bit = Column(1) << y;
+    if (id == BLOCK_AIR)
+    {
+        Column column = readColumn(columnIndex);
+        if ((column & bit) == 0)
+        {
+            return; // 既に空気
+        }
+        writeColumn(columnIndex, column & ~bit);
+        // 空気のボクセルの素材は使われないので既定に戻し、消えた素材のパレットのエントリを空ける
+        m_materials.set(getMaterialIndex(x, y, z), DEFAULT_SOLID_BLOCK);
+    }
+    else
+    {
+        writeColumn(columnIndex, readColumn(columnIndex) | bit);
+        m_materials.set(getMaterialIndex(x, y, z), id);
+    }
+    setDirty(true);
 }
 
-size_t Chunk::getIndex(int x, int y, int z) const
+void Chunk::checkBounds(int x, int y, int z) const
 {
     if (x < 0 || x >= m_size || y < 0 || y >= m_size || z < 0 || z >= m_size)
     {
         throw std::out_of_range("Voxel coordinates out of chunk bounds.");
     }
-    return static_cast<size_t>(x + y * m_size + z * m_size * m_size);
 }
 
 bool Chunk::getVoxel(int x, int y, int z) const
 {
-    return m_voxels[getIndex(x, y, z)];
+    checkBounds(x, y, z);
+    return (getColumn(x, z) >> y) & 1;
+}
+
+void Chunk::setColumn(int x, int z, Column mask)
+{
+    size_t columnIndex = getColumnIndex(x, z);
+    mask &= m_fullColumnMask;
+    resetMaterials(columnIndex, mask ^ readColumn(columnIndex));
+    writeColumn(columnIndex, mask);
+    setDirty(true);
 }
 
-void Chunk::setVoxels(const std::vector<bool> &voxels)
+void Chunk::resetMaterials(size_t columnIndex, Column changed)
 {
-    if (voxels.size() != static_cast<size_t>(m_size * m_size * m_size))
+    // パレットが単一素材ならインデックス配列がないので何もしなくてよい
+    if (m_materials.getBitsPerEntry() == 0 && m_materials.getPalette()[0] == DEFAULT_SOLID_BLOCK)
+    {
+        return;
+    }
+    while (changed != 0)
+    {
+        int y = bits::countTrailingZeros(changed);
+        changed &= changed - 1;
+        m_materials.set(static_cast<size_t>(y) + columnIndex * m_size, DEFAULT_SOLID_BLOCK);
+    }
+}
+
+void Chunk::setColumns(const std::vector<Column> &columns)
+{
+    if (columns.size() != static_cast<size_t>(m_size * m_size))
+    {
+        throw std::invalid_argument("Input column data size does not match chunk dimensions.");
+    }
+    // 全列が同じく空 / 満杯なら列バッファを持たない一様なチャンクにする
+    Column first = columns[0] & m_fullColumnMask;
+    bool uniform = (first == 0 || first == m_fullColumnMask);
+    for (size_t i = 1; uniform && i < columns.size(); ++i)
     {
-        throw std::invalid_argument("Input voxel data size does not match chunk dimensions.");
+        uniform = ((columns[i] & m_fullColumnMask) == first);
     }
-    m_voxels = voxels;
-    m_isDirty = true;
-}
\ No newline at end of file
+    if (uniform)
+    {
+        fill(first == 0 ? BLOCK_AIR : DEFAULT_SOLID_BLOCK);
+        return;
+    }
+
+    if (m_columnWords.empty())
+    {
+        allocateColumns();
+    }
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        writeColumn(i, columns[i]);
+    }
+    // チャンク全体を置き換えるので素材も単一素材に戻す
+    m_materials.fill(DEFAULT_SOLID_BLOCK);
+    setDirty(true);
+}
+
+void Chunk::getSlab(int y, Column *rowsOut) const
+{
+    if (isUniform())
+    {
+        Column row = ((m_uniformColumn >> y) & 1) ? m_fullColumnMask : 0;
+        for (int z = 0; z < m_size; ++z)
+        {
+            rowsOut[z] = row;
+        }
+        return;
+    }
+
+    // ワードごとに、各スロットのビット y をまとめて取り出して下位ビットへ詰める
+    // (スロットの間隔 slotBits で並んだビットを、隣どうし結合しながら連続させる)
+    const int slotBits = 1 << m_columnSlotShift;
+    const int columnsPerWord = 1 << m_columnsPerWordShift;
+    std::uint64_t slotLowBits = 0;
+    for (int i = 0; i < columnsPerWord; ++i)
+    {
+        slotLowBits |= std::uint64_t(1) << (i * slotBits);
+    }
+    // 結合の各段のシフト量とマスク (1ワードの列数は最大 8 なので最大 3 段)
+    std::array<int, 3> foldShifts{};
+    std::array<std::uint64_t, 3> foldMasks{};
+    int foldCount = 0;
+    for (int groupBits = 1, stride = slotBits; stride < 64; groupBits *= 2, stride *= 2, ++foldCount)
+    {
+        foldShifts[foldCount] = stride - groupBits;
+        foldMasks[foldCount] = 0;
+        for (int i = 0; i < 64; i += stride * 2)
+        {
+            foldMasks[foldCount] |= bits::lowMask(groupBits * 2) << i;
+        }
+    }
+
+    // 列インデックス x + z * size の順に詰めたビット列を、size ビットずつ行として書き出す
+    Column row = 0;
+    int rowBits = 0;
+    int z = 0;
+    for (std::uint64_t word : m_columnWords)
+    {
+        std::uint64_t packed = (word >> y) & slotLowBits;
+        for (int i = 0; i < foldCount; ++i)
+        {
+            packed = (packed | (packed >> foldShifts[i])) & foldMasks[i];
+        }
+
+        int remaining = columnsPerWord;
+        while (remaining > 0 && z < m_size)
+        {
+            int take = std::min(remaining, m_size - rowBits);
+            row |= (packed & bits::lowMask(take)) << rowBits;
+            packed >>= take;
+            rowBits += take;
+            remaining -= take;
+            if (rowBits == m_size)
+            {
+                rowsOut[z++] = row;
+                row = 0;
+                rowBits = 0;
+            }
+        }
+    }
+}
+
+int Chunk::countSolidVoxels() const
+{
+    if (isUniform())
+    {
+        return m_uniformColumn != 0 ? m_size * m_size * m_size : 0;
+    }
+    int count = 0;
+    // スロットの未使用ビットは常に 0 なので、ワード単位でまとめて数えられる
+    for (std::uint64_t word : m_columnWords)
+    {
+        count += bits::popcount(word);
+    }
+    return count;
+}
+
+size_t Chunk::getMemoryUsage() const
+{
+    return m_columnWords.capacity() * sizeof(std::uint64_t) + m_materials.getMemoryUsage();
+}
+
+std::uint64_t Chunk::getBorderSignature(int faceIndex) const
+{
+    if (!m_borderSignaturesValid)
+    {
+        computeBorderSignatures();
+    }
+    return m_borderSignatures[faceIndex];
+}
+
+void Chunk::computeBorderSignatures() const
+{
+    m_borderSignaturesValid = true;
+    if (isUniformAir())
+    {
+        m_borderSignatures.fill(EMPTY_BORDER_SIGNATURE);
+        return;
+    }
+
+    // 各面の層を列マスク (X, Z 面) または行マスク (Y 面) の並びとしてハッシュする
+    std::array<Column, MAX_SIZE> slice;
+    const int last = m_size - 1;
+    for (int i = 0; i < m_size; ++i)
+    {
+        slice[i] = getColumn(i, 0);
+    }
+    m_borderSignatures[0] = hashBorderSlice(slice.data(), m_size); // Z-
+    for (int i = 0; i < m_size; ++i)
+    {
+        slice[i] = getColumn(i, last);
+    }
+    m_borderSignatures[1] = hashBorderSlice(slice.data(), m_size); // Z+
+    for (int i = 0; i < m_size; ++i)
+    {
+        slice[i] = getColumn(0, i);
+    }
+    m_borderSignatures[2] = hashBorderSlice(slice.data(), m_size); // X-
+    for (int i = 0; i < m_size; ++i)
+    {
+        slice[i] = getColumn(last, i);
+    }
+    m_borderSignatures[3] = hashBorderSlice(slice.data(), m_size); // X+
+    getSlab(0, slice.data());
+    m_borderSignatures[4] = hashBorderSlice(slice.data(), m_size); // Y-
+    getSlab(last, slice.data());
+    m_borderSignatures[5] = hashBorderSlice(slice.data(), m_size); // Y+
+}
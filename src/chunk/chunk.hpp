@@ -1,32 +1,126 @@
 #ifndef CHUNK_HPP
 #define CHUNK_HPP
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp> // glm::ivec3 のために追加
+#include "block_types.hpp"
+#include "palette_storage.hpp"
 
+class Chunk;
+
+// チャンクの内容が変更されたときに通知を受け取るインターフェース
+// 通知はダーティでない状態からダーティになったときだけ行われる (setDirty(false) までの変更は1回にまとめられる)
+// 通知は変更したスレッドで呼ばれるので、リスナーを設定したチャンクはメインスレッドからのみ変更すること
+// ChunkManager が保持するチャンクはメッシュ生成ジョブがロックなしで読むため、直接変更してはならない。
+// 編集は ChunkManager::editChunk で行う (複製を編集して差し替えるので、ジョブが読んでいる版は変化しない)
+class ChunkChangeListener {
+public:
+    virtual ~ChunkChangeListener() = default;
+    virtual void onChunkDirty(Chunk& chunk) = 0;
+};
+
+// ボクセルは Y 軸方向の列ごとにビットパックして保持する。
+// 列 (x, z) のビット y がボクセル (x, y, z) のソリッド状態に対応する。
+// 列は size 以上の最小の 8/16/32/64 ビット幅のスロットに詰めて 64bit ワードへ格納する
+// (size 16 なら 1 ワードに 4 列、1 ボクセルあたり 1 ビット)。
+// 全て空気、または全てソリッドの一様なチャンクは列バッファを確保せず、
+// 単一の値だけで表現する (生成直後のチャンクは一様な空気)。
+// ソリッドなボクセルの素材 (BlockId) は別途パレット圧縮して保持する。
+// メッシュ生成などソリッドかどうかだけを見る処理は列マスクだけを参照すればよい。
 class Chunk {
 public:
+    using Column = std::uint64_t;
+    // 扱える最大サイズ。メッシュ生成で上下に近傍の1ボクセルずつを足した列 (size + 2 ビット) が1ワードに収まり、
+    // 頂点のパック済み座標 (7bit、0〜size) にも収まる大きさ。これより大きいサイズは構築時に拒否する
+    static constexpr int MAX_SIZE = 62;
+
     // コンストラクタに座標パラメータを追加
-    explicit Chunk(int size, const glm::ivec3& coord); 
-    
+    explicit Chunk(int size, const glm::ivec3& coord);
+
     bool getVoxel(int x, int y, int z) const;
     void setVoxel(int x, int y, int z, bool value);
-    void setVoxels(const std::vector<bool>& voxels);
 
-    const std::vector<bool>& getVoxels() const { return m_voxels; }
+    // 素材付きのブロックアクセス (BLOCK_AIR を設定すると空気になる)
+    BlockId getBlock(int x, int y, int z) const;
+    void setBlock(int x, int y, int z, BlockId id);
+    const PaletteStorage& getMaterials() const { return m_materials; }
+    // ソリッドなボクセルの素材 (境界チェックなし。空気のボクセルでは意味のない値を返す)
+    // メッシュ生成など、列マスクでソリッドと分かっているボクセルについて呼ぶ
+    BlockId getSolidBlock(int x, int y, int z) const { return m_materials.get(getMaterialIndex(x, y, z)); }
+
+    // 列単位のバルクアクセス (境界チェックなし、0 <= x, z < size であること)
+    // 列マスクで新たにソリッドになったボクセルの素材は DEFAULT_SOLID_BLOCK になる
+    Column getColumn(int x, int z) const { return readColumn(getColumnIndex(x, z)); }
+    void setColumn(int x, int z, Column mask);
+    void setColumns(const std::vector<Column>& columns);
+
+    // 一様なチャンクかどうか (列バッファを持たない)
+    bool isUniform() const { return m_columnWords.empty(); }
+    bool isUniformAir() const { return isUniform() && m_uniformColumn == 0; }
+    bool isUniformSolid() const { return isUniform() && m_uniformColumn != 0; }
+    // チャンク全体を1種類のブロックで埋め、一様なチャンクにする
+    void fill(BlockId id);
+
+    // 6 方向 (Z-, Z+, X-, X+, Y-, Y+) の境界の層 (最も外側の1層) のソリッド状態のハッシュ
+    // 隣接チャンクのメッシュはこの層だけを参照するので、値が変わらなければ作り直す必要はない。
+    // 境界が全て空気なら EMPTY_BORDER_SIGNATURE (存在しないチャンクと同じ扱い) になる。
+    // 変更されるまで結果はキャッシュされる (メインスレッドからのみ呼ぶこと)
+    static constexpr std::uint64_t EMPTY_BORDER_SIGNATURE = 0;
+    std::uint64_t getBorderSignature(int faceIndex) const;
+
+    // 高さ y の XZ スラブを X 方向の行マスクとして取得 (rowsOut[z] のビット x)
+    void getSlab(int y, Column* rowsOut) const;
+
+    // 列内で有効なビットのマスク (下位 size ビット)
+    Column getFullColumnMask() const { return m_fullColumnMask; }
+    // ソリッドなボクセル数
+    int countSolidVoxels() const;
+    // ボクセルデータが使用しているおおよそのバイト数
+    size_t getMemoryUsage() const;
+
     int getSize() const { return m_size; }
     bool isDirty() const { return m_isDirty; }
-    void setDirty(bool dirty) { m_isDirty = dirty; }
+    void setDirty(bool dirty);
+    // 変更の通知先 (nullptr で通知しない)
+    void setChangeListener(ChunkChangeListener* listener) { m_changeListener = listener; }
 
     // 新しく追加するメソッド
     glm::ivec3 getCoord() const { return m_coord; }
 
 private:
-    size_t getIndex(int x, int y, int z) const;
-    std::vector<bool> m_voxels;
+    size_t getColumnIndex(int x, int z) const { return static_cast<size_t>(x + z * m_size); }
+    // 素材配列のインデックス (列ごとに連続するよう Y を最下位に置く)
+    size_t getMaterialIndex(int x, int y, int z) const { return static_cast<size_t>(y) + getColumnIndex(x, z) * m_size; }
+    Column readColumn(size_t columnIndex) const
+    {
+        if (m_columnWords.empty())
+        {
+            return m_uniformColumn;
+        }
+        return (m_columnWords[columnIndex >> m_columnsPerWordShift] >>
+                ((columnIndex & m_columnInWordMask) << m_columnSlotShift)) & m_fullColumnMask;
+    }
+    void writeColumn(size_t columnIndex, Column mask);
+    void allocateColumns();
+    void checkBounds(int x, int y, int z) const;
+    // changed のビットのボクセル (新たにソリッドになった、または空気になった) の素材を既定に戻す
+    void resetMaterials(size_t columnIndex, Column changed);
+    void computeBorderSignatures() const;
+    std::vector<std::uint64_t> m_columnWords; // 一様なチャンクでは空
+    Column m_uniformColumn;                   // 一様なチャンクの全列の値 (0 か全ビット)
+    PaletteStorage m_materials; // ソリッドなボクセルの素材 (空気のボクセルの値は未使用)
     int m_size;
+    Column m_fullColumnMask;
+    int m_columnSlotShift;       // 列スロットのビット幅の log2 (3〜6)
+    int m_columnsPerWordShift;   // 1ワードあたりの列数の log2
+    size_t m_columnInWordMask;   // ワード内の列位置を取り出すマスク
     bool m_isDirty;
+    ChunkChangeListener* m_changeListener;
     glm::ivec3 m_coord; // チャンクのワールド座標
+    mutable std::array<std::uint64_t, 6> m_borderSignatures; // getBorderSignature のキャッシュ
+    mutable bool m_borderSignaturesValid;
 };
 
 #endif // CHUNK_HPP
\ No newline at end of file
@@ -0,0 +1,191 @@
+#include "palette_storage.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace
+{
+    // paletteSize 種類を表現できる最小のビット幅 (0/1/2/4/8/16)
+    int getBitsForPaletteSize(size_t paletteSize)
+    {
+        int bits = 0;
+        while ((size_t(1) << bits) < paletteSize)
+        {
+            bits = std::max(1, bits * 2);
+        }
+        return bits;
+    }
+}
+
+PaletteStorage::PaletteStorage(size_t entryCount, BlockId initialId)
+    : m_entryCount(entryCount), m_bitsPerEntry(0), m_palette{initialId},
+      m_paletteCounts{static_cast<std::uint32_t>(entryCount)}, m_usedPaletteEntries(1)
+{
+}
+
+BlockId PaletteStorage::get(size_t index) const
+{
+    return m_palette[readIndex(index)];
+}
+
+void PaletteStorage::set(size_t index, BlockId id)
+{
+    unsigned int oldPaletteIndex = readIndex(index);
+    if (m_palette[oldPaletteIndex] == id)
+    {
+        return;
+    }
+    // 拡張してもインデックスの値は変わらないので、oldPaletteIndex はそのまま使える
+    unsigned int newPaletteIndex = findOrAddPaletteIndex(id);
+    writeIndex(index, newPaletteIndex);
+    ++m_paletteCounts[newPaletteIndex];
+    if (--m_paletteCounts[oldPaletteIndex] != 0)
+    {
+        return;
+    }
+
+    // 使われなくなったエントリが増え、狭いビット幅に半分以下で収まるなら詰め直す
+    // (半分の余裕を残すのは、境界の前後で種類が増減するたびに拡張と縮小を繰り返さないため)
+    --m_usedPaletteEntries;
+    int compactBits = m_usedPaletteEntries <= 1 ? 0 : getBitsForPaletteSize(m_usedPaletteEntries * 2);
+    if (compactBits < m_bitsPerEntry)
+    {
+        compact(compactBits);
+    }
+}
+
+void PaletteStorage::fill(BlockId id)
+{
+    m_palette.assign(1, id);
+    m_paletteCounts.assign(1, static_cast<std::uint32_t>(m_entryCount));
+    m_usedPaletteEntries = 1;
+    m_bitsPerEntry = 0;
+    m_data.clear();
+    m_data.shrink_to_fit();
+}
+
+size_t PaletteStorage::getMemoryUsage() const
+{
+    return m_palette.capacity() * sizeof(BlockId) + m_paletteCounts.capacity() * sizeof(std::uint32_t) +
+           m_data.capacity() * sizeof(std::uint64_t);
+}
+
+unsigned int PaletteStorage::findOrAddPaletteIndex(BlockId id)
+{
+    auto it = std::find(m_palette.begin(), m_palette.end(), id);
+    if (it != m_palette.end())
+    {
+        unsigned int paletteIndex = static_cast<unsigned int>(it - m_palette.begin());
+        if (m_paletteCounts[paletteIndex] == 0)
+        {
+            ++m_usedPaletteEntries;
+        }
+        return paletteIndex;
+    }
+
+    // 参照されなくなったエントリがあれば、ビット幅を広げずにそこを使う
+    auto unused = std::find(m_paletteCounts.begin(), m_paletteCounts.end(), 0u);
+    if (unused != m_paletteCounts.end())
+    {
+        unsigned int paletteIndex = static_cast<unsigned int>(unused - m_paletteCounts.begin());
+        m_palette[paletteIndex] = id;
+        ++m_usedPaletteEntries;
+        return paletteIndex;
+    }
+
+    // 現在のビット幅で表現できなくなる場合は先にインデックス配列を拡張する
+    size_t newPaletteSize = m_palette.size() + 1;
+    if (newPaletteSize > (size_t(1) << m_bitsPerEntry))
+    {
+        int newBits = std::max(1, m_bitsPerEntry * 2);
+        if (newBits > 16)
+        {
+            throw std::length_error("Palette cannot hold more than 65536 block types.");
+        }
+        resize(newBits);
+    }
+    m_palette.push_back(id);
+    m_paletteCounts.push_back(0);
+    ++m_usedPaletteEntries;
+    return static_cast<unsigned int>(m_palette.size() - 1);
+}
+
+// 参照されているエントリだけのパレットに作り直し、インデックス配列を newBitsPerEntry ビットで詰め直す
+void PaletteStorage::compact(int newBitsPerEntry)
+{
+    std::vector<unsigned int> remap(m_palette.size(), 0);
+    std::vector<BlockId> newPalette;
+    std::vector<std::uint32_t> newCounts;
+    newPalette.reserve(m_usedPaletteEntries);
+    newCounts.reserve(m_usedPaletteEntries);
+    for (size_t i = 0; i < m_palette.size(); ++i)
+    {
+        if (m_paletteCounts[i] != 0)
+        {
+            remap[i] = static_cast<unsigned int>(newPalette.size());
+            newPalette.push_back(m_palette[i]);
+            newCounts.push_back(m_paletteCounts[i]);
+        }
+    }
+
+    std::vector<std::uint64_t> newData;
+    if (newBitsPerEntry > 0)
+    {
+        size_t entriesPerWord = WORD_BITS / newBitsPerEntry;
+        newData.assign((m_entryCount + entriesPerWord - 1) / entriesPerWord, 0);
+        for (size_t i = 0; i < m_entryCount; ++i)
+        {
+            std::uint64_t value = remap[readIndex(i)];
+            newData[i / entriesPerWord] |= value << ((i % entriesPerWord) * newBitsPerEntry);
+        }
+    }
+
+    m_palette.swap(newPalette);
+    m_paletteCounts.swap(newCounts);
+    m_data.swap(newData);
+    m_bitsPerEntry = newBitsPerEntry;
+}
+
+void PaletteStorage::resize(int newBitsPerEntry)
+{
+    size_t entriesPerWord = WORD_BITS / newBitsPerEntry;
+    std::vector<std::uint64_t> newData((m_entryCount + entriesPerWord - 1) / entriesPerWord, 0);
+
+    if (m_bitsPerEntry > 0)
+    {
+        for (size_t i = 0; i < m_entryCount; ++i)
+        {
+            std::uint64_t value = readIndex(i);
+            newData[i / entriesPerWord] |= value << ((i % entriesPerWord) * newBitsPerEntry);
+        }
+    }
+    // 0 ビットからの拡張では全要素がパレット 0 番なので、ゼロ埋めのままでよい
+
+    m_data.swap(newData);
+    m_bitsPerEntry = newBitsPerEntry;
+}
+
+unsigned int PaletteStorage::readIndex(size_t index) const
+{
+    if (m_bitsPerEntry == 0)
+    {
+        return 0;
+    }
+    // ビット幅は 64 の約数なので、要素がワード境界をまたぐことはない
+    size_t entriesPerWord = WORD_BITS / m_bitsPerEntry;
+    std::uint64_t word = m_data[index / entriesPerWord];
+    std::uint64_t mask = (std::uint64_t(1) << m_bitsPerEntry) - 1;
+    return static_cast<unsigned int>((word >> ((index % entriesPerWord) * m_bitsPerEntry)) & mask);
+}
+
+void PaletteStorage::writeIndex(size_t index, unsigned int paletteIndex)
+{
+    if (m_bitsPerEntry == 0)
+    {
+        return; // パレットが1種類のみなら書き込むものはない
+    }
+    size_t entriesPerWord = WORD_BITS / m_bitsPerEntry;
+    int shift = static_cast<int>((index % entriesPerWord) * m_bitsPerEntry);
+    std::uint64_t mask = ((std::uint64_t(1) << m_bitsPerEntry) - 1) << shift;
+    std::uint64_t &word = m_data[index / entriesPerWord];
+    word = (word & ~mask) | ((static_cast<std::uint64_t>(paletteIndex) << shift) & mask);
+}
@@ -0,0 +1,48 @@
+#ifndef PALETTE_STORAGE_HPP
+#define PALETTE_STORAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "block_types.hpp"
+
+// パレット圧縮されたブロックID配列
+// 各要素はパレットへのインデックスとして保持し、インデックスのビット幅は
+// パレットのサイズに応じて 0/1/2/4/8/16 ビットへ自動的に拡張される。
+// パレットが1種類だけの間はインデックス配列を確保しない (0 ビット)。
+// パレットの各エントリを参照している要素数を数えておき、参照されなくなったエントリは新しいブロックに再利用する。
+// 使われているエントリ数が狭いビット幅に余裕を持って収まるまで減ったら、パレットを詰め直してビット幅を縮める。
+class PaletteStorage
+{
+public:
+    PaletteStorage(size_t entryCount, BlockId initialId);
+
+    BlockId get(size_t index) const;
+    void set(size_t index, BlockId id);
+
+    // 全要素を1種類のブロックで埋め直す (インデックス配列は解放される)
+    void fill(BlockId id);
+
+    int getBitsPerEntry() const { return m_bitsPerEntry; }
+    const std::vector<BlockId> &getPalette() const { return m_palette; }
+    // パレットとインデックス配列が使用しているおおよそのバイト数
+    size_t getMemoryUsage() const;
+
+private:
+    static constexpr int WORD_BITS = 64;
+
+    size_t m_entryCount;
+    int m_bitsPerEntry;
+    std::vector<BlockId> m_palette;
+    std::vector<std::uint32_t> m_paletteCounts; // パレットのエントリごとの参照数 (m_palette と同じ並び)
+    size_t m_usedPaletteEntries;                // 参照数が 0 でないエントリの数
+    std::vector<std::uint64_t> m_data;
+
+    unsigned int findOrAddPaletteIndex(BlockId id);
+    void resize(int newBitsPerEntry);
+    void compact(int newBitsPerEntry);
+    unsigned int readIndex(size_t index) const;
+    void writeIndex(size_t index, unsigned int paletteIndex);
+};
+
+#endif // PALETTE_STORAGE_HPP
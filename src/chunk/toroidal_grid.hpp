@@ -0,0 +1,54 @@
+#ifndef TOROIDAL_GRID_HPP
+#define TOROIDAL_GRID_HPP
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+#include <glm/glm.hpp>
+
+// 座標を各軸 size で割った余りで格納する 3 次元のリングバッファ
+// 一辺 size の範囲に収まる座標同士は必ず別のスロットになるため、ロード範囲の直径を size にすれば
+// 範囲内のチャンクをハッシュなしの配列参照で引ける。範囲が移動してもスロットを使い回すだけで再確保しない。
+// スロットがどの座標のものかは呼び出し側で管理する (同じスロットを共有する座標は区別されない)
+template <typename T>
+class ToroidalGrid
+{
+public:
+    explicit ToroidalGrid(int size)
+        : m_size(size), m_slots(getSlotCount(size))
+    {
+    }
+
+    T &at(const glm::ivec3 &coord) { return m_slots[getIndex(coord)]; }
+    const T &at(const glm::ivec3 &coord) const { return m_slots[getIndex(coord)]; }
+
+    int getSize() const { return m_size; }
+
+private:
+    int m_size;
+    std::vector<T> m_slots;
+
+    // スロットを確保する前に検査する (負の size を size_t にすると巨大な確保になる)
+    static size_t getSlotCount(int size)
+    {
+        if (size <= 0)
+        {
+            throw std::invalid_argument("ToroidalGrid size must be positive.");
+        }
+        return static_cast<size_t>(size) * size * size;
+    }
+
+    int wrap(int value) const
+    {
+        int m = value % m_size;
+        return m < 0 ? m + m_size : m;
+    }
+    size_t getIndex(const glm::ivec3 &coord) const
+    {
+        return static_cast<size_t>(wrap(coord.x)) +
+               static_cast<size_t>(wrap(coord.y)) * m_size +
+               static_cast<size_t>(wrap(coord.z)) * m_size * m_size;
+    }
+};
+
+#endif // TOROIDAL_GRID_HPP
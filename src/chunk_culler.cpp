@@ -0,0 +1,195 @@
+#include "chunk_culler.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include "chunk/bit_utils.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CHUNK_CULLER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CHUNK_CULLER_SSE 1
+#endif
+
+// 並列カリング中に、呼び出し元とワーカーが共有する状態
+// 後から起動したワーカーが参照しても大丈夫なように shared_ptr で保持する
+struct ChunkCuller::ParallelCullState
+{
+    CullPlanes planes;
+    size_t boxCount = 0;
+    size_t rangeCount = 0;
+    std::atomic<size_t> nextRange{0};
+    std::atomic<size_t> completedRanges{0};
+    std::vector<std::vector<std::uint32_t>> results; // 範囲ごとの結果 (範囲の順に連結する)
+};
+
+size_t ChunkCuller::add(const glm::vec3 &minPoint, const glm::vec3 &maxPoint)
+{
+    m_minX.push_back(minPoint.x);
+    m_minY.push_back(minPoint.y);
+    m_minZ.push_back(minPoint.z);
+    m_maxX.push_back(maxPoint.x);
+    m_maxY.push_back(maxPoint.y);
+    m_maxZ.push_back(maxPoint.z);
+    return m_minX.size() - 1;
+}
+
+void ChunkCuller::remove(size_t index)
+{
+    size_t last = m_minX.size() - 1;
+    m_minX[index] = m_minX[last];
+    m_minY[index] = m_minY[last];
+    m_minZ[index] = m_minZ[last];
+    m_maxX[index] = m_maxX[last];
+    m_maxY[index] = m_maxY[last];
+    m_maxZ[index] = m_maxZ[last];
+    m_minX.pop_back();
+    m_minY.pop_back();
+    m_minZ.pop_back();
+    m_maxX.pop_back();
+    m_maxY.pop_back();
+    m_maxZ.pop_back();
+}
+
+void ChunkCuller::cull(const Frustum &frustum, std::vector<std::uint32_t> &visible, ThreadPool *pool) const
+{
+    visible.clear();
+    size_t boxCount = size();
+    if (boxCount == 0)
+    {
+        return;
+    }
+
+    size_t rangeCount = (boxCount + PARALLEL_RANGE_SIZE - 1) / PARALLEL_RANGE_SIZE;
+    if (!pool || rangeCount < 2)
+    {
+        cullRange(buildCullPlanes(frustum), 0, boxCount, visible);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelCullState>();
+    state->planes = buildCullPlanes(frustum);
+    state->boxCount = boxCount;
+    state->rangeCount = rangeCount;
+    state->results.resize(rangeCount);
+
+    size_t helperCount = std::min(pool->getThreadCount(), rangeCount - 1);
+    for (size_t i = 0; i < helperCount; ++i)
+    {
+        pool->execute([state]()
+                      { runParallelRanges(*state); });
+    }
+    runParallelRanges(*state);
+    // 他のスレッドが取った範囲の完了を待つ (範囲は短いので、ほとんど待たない)
+    while (state->completedRanges.load(std::memory_order_acquire) < rangeCount)
+    {
+        std::this_thread::yield();
+    }
+
+    for (const std::vector<std::uint32_t> &result : state->results)
+    {
+        visible.insert(visible.end(), result.begin(), result.end());
+    }
+}
+
+ChunkCuller::CullPlanes ChunkCuller::buildCullPlanes(const Frustum &frustum) const
+{
+    CullPlanes planes;
+    const std::array<Plane, 6> &frustumPlanes = frustum.getPlanes();
+    for (size_t i = 0; i < planes.size(); ++i)
+    {
+        const Plane &plane = frustumPlanes[i];
+        planes[i] = {plane.normal.x, plane.normal.y, plane.normal.z, plane.distance,
+                     plane.normal.x >= 0 ? m_maxX.data() : m_minX.data(),
+                     plane.normal.y >= 0 ? m_maxY.data() : m_minY.data(),
+                     plane.normal.z >= 0 ? m_maxZ.data() : m_minZ.data()};
+    }
+    return planes;
+}
+
+// [begin, end) の箱を判定する。p-vertex が1つでも平面の裏側にあれば、その箱は外側
+void ChunkCuller::cullRange(const CullPlanes &planes, size_t begin, size_t end, std::vector<std::uint32_t> &visible)
+{
+    size_t i = begin;
+#if defined(CHUNK_CULLER_AVX2)
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (const CullPlane &plane : planes)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.normalX), _mm256_loadu_ps(plane.xs + i)),
+                                            _mm256_mul_ps(_mm256_set1_ps(plane.normalY), _mm256_loadu_ps(plane.ys + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.normalZ), _mm256_loadu_ps(plane.zs + i)));
+            distance = _mm256_add_ps(distance, _mm256_set1_ps(plane.distance));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+        }
+        std::uint64_t mask = static_cast<std::uint32_t>(_mm256_movemask_ps(inside));
+        while (mask != 0)
+        {
+            visible.push_back(static_cast<std::uint32_t>(i + bits::countTrailingZeros(mask)));
+            mask &= mask - 1;
+        }
+    }
+#elif defined(CHUNK_CULLER_SSE)
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (const CullPlane &plane : planes)
+        {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.normalX), _mm_loadu_ps(plane.xs + i)),
+                                         _mm_mul_ps(_mm_set1_ps(plane.normalY), _mm_loadu_ps(plane.ys + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.normalZ), _mm_loadu_ps(plane.zs + i)));
+            distance = _mm_add_ps(distance, _mm_set1_ps(plane.distance));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+        }
+        std::uint64_t mask = static_cast<std::uint32_t>(_mm_movemask_ps(inside));
+        while (mask != 0)
+        {
+            visible.push_back(static_cast<std::uint32_t>(i + bits::countTrailingZeros(mask)));
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    // SIMD の幅に満たない残り (SIMD が使えない環境では全て)
+    for (; i < end; ++i)
+    {
+        bool inside = true;
+        for (const CullPlane &plane : planes)
+        {
+            float distance = plane.normalX * plane.xs[i] + plane.normalY * plane.ys[i] + plane.normalZ * plane.zs[i] +
+                             plane.distance;
+            if (distance < 0.0f)
+            {
+                inside = false;
+                break;
+            }
+        }
+        if (inside)
+        {
+            visible.push_back(static_cast<std::uint32_t>(i));
+        }
+    }
+}
+
+// 残っている範囲を1つずつ取って判定する。全ての範囲が取られたら戻る
+void ChunkCuller::runParallelRanges(ParallelCullState &state)
+{
+    for (;;)
+    {
+        size_t range = state.nextRange.fetch_add(1, std::memory_order_relaxed);
+        if (range >= state.rangeCount)
+        {
+            return;
+        }
+        size_t begin = range * PARALLEL_RANGE_SIZE;
+        size_t end = std::min(state.boxCount, begin + PARALLEL_RANGE_SIZE);
+        cullRange(state.planes, begin, end, state.results[range]);
+        state.completedRanges.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef CHUNK_CULLER_HPP
+#define CHUNK_CULLER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frustum.hpp"
+#include "thread/thread_pool.hpp"
+
+// 描画対象のチャンクの AABB を成分ごとの連続した配列 (SoA) で保持し、視錐台カリングをまとめて行う
+// 判定は AVX2 なら8個、SSE なら4個ずつ行い、見える箱の番号だけを詰めて書き出す
+// 箱の番号は追加順の位置で、remove では末尾の箱を空いた位置へ移す (利用側も同じ入れ替えを行うこと)
+class ChunkCuller
+{
+public:
+    // 箱を末尾に追加し、その番号を返す
+    size_t add(const glm::vec3 &minPoint, const glm::vec3 &maxPoint);
+    // index の箱を削除し、末尾の箱を index へ移す
+    void remove(size_t index);
+    size_t size() const { return m_minX.size(); }
+
+    // 視錐台と交差する (または内側にある) 箱の番号を昇順で visible に書き出す
+    // pool を渡した場合、箱が多ければ範囲に分けて、呼び出し元のスレッドとワーカーで分担する
+    // (呼び出し元も範囲を取りに行くので、ワーカーが他のジョブで埋まっていても待たされない)
+    void cull(const Frustum &frustum, std::vector<std::uint32_t> &visible, ThreadPool *pool = nullptr) const;
+
+private:
+    // 並列化するときの1範囲の箱の数 (これ以下ならワーカーを使わない)
+    static constexpr size_t PARALLEL_RANGE_SIZE = 16384;
+
+    // 平面ごとに、法線方向に最も進んだ頂点 (p-vertex) の各成分をどちらの配列から読むかを決めておく
+    struct CullPlane
+    {
+        float normalX, normalY, normalZ, distance;
+        const float *xs;
+        const float *ys;
+        const float *zs;
+    };
+    using CullPlanes = std::array<CullPlane, 6>;
+
+    struct ParallelCullState;
+
+    std::vector<float> m_minX, m_minY, m_minZ;
+    std::vector<float> m_maxX, m_maxY, m_maxZ;
+
+    CullPlanes buildCullPlanes(const Frustum &frustum) const;
+    static void cullRange(const CullPlanes &planes, size_t begin, size_t end, std::vector<std::uint32_t> &visible);
+    static void runParallelRanges(ParallelCullState &state);
+};
+
+#endif // CHUNK_CULLER_HPP
@@ -1,12 +1,53 @@
 #include "chunk_manager.hpp"
 #include <iostream>
-#include <chrono>
 #include <algorithm>
 #include <limits>
 // chunk_mesh_generator.hpp は ChunkProcessor でのみ使用されるため、ここからは削除可能
-// chunk_renderer.hpp は updateChunkRenderData で使用するため残す
+// chunk_renderer.hpp はメッシュ完了時の描画データ作成で使用するため残す
 #include "chunk_renderer.hpp"
 
+namespace
+{
+    // メインスレッドでの GPU 作業の時間予算 (FrameBudget) の設定
+    constexpr double TARGET_FRAME_SECONDS = 1.0 / 60.0;
+    constexpr double MIN_GPU_WORK_BUDGET_SECONDS = 0.0005;
+    constexpr double MAX_GPU_WORK_BUDGET_SECONDS = 0.008;
+    // 削除待ちがあるときに削除用に残す予算の割合
+    constexpr double RELEASE_BUDGET_SHARE = 0.25;
+    // 計測値が得られるまでの所要時間の見積もり
+    constexpr double INITIAL_UPLOAD_SECONDS_PER_VERTEX = 2.0e-8;
+    constexpr double INITIAL_RELEASE_SECONDS = 1.0e-6;
+    constexpr double INITIAL_DEFRAGMENT_SECONDS_PER_BYTE = 1.0e-9;
+    // デフラグでのコピーは GPU 側で行われ、CPU 時間では測れないので1フレームの量を別に制限する
+    constexpr size_t MAX_DEFRAGMENT_BYTES_PER_FRAME = 1 << 20;
+    // 視線の向きがこの角度 (約 30 度) を超えて変わったら、待っているジョブの優先度を求め直す
+    constexpr float PRIORITY_HEADING_COS_THRESHOLD = 0.866f;
+
+    // offset の位置にある近傍チャンクのうち、中央のチャンクに接する境界のシグネチャ
+    // 辺・角で接する近傍は、接している複数の面のシグネチャを合成する (辺・角を含む上位集合)
+    // 存在しないチャンクと境界が全て空気のチャンクは同じ値 (メッシュ生成では共に空気として扱われる)
+    std::uint64_t getFacingBorderSignature(const Chunk *neighborChunk, const glm::ivec3 &offset)
+    {
+        if (!neighborChunk)
+        {
+            return Chunk::EMPTY_BORDER_SIGNATURE;
+        }
+        // 近傍から見て中央のチャンクがある側の面 (Z-, Z+, X-, X+, Y-, Y+)
+        const int facingFaces[3][2] = {{2, 3}, {4, 5}, {0, 1}}; // 軸 x, y, z の {+1 側の近傍, -1 側の近傍}
+        std::uint64_t signature = Chunk::EMPTY_BORDER_SIGNATURE;
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            if (offset[axis] == 0)
+            {
+                continue;
+            }
+            int faceIndex = offset[axis] > 0 ? facingFaces[axis][0] : facingFaces[axis][1];
+            signature = ((signature << 13) | (signature >> 51)) ^ neighborChunk->getBorderSignature(faceIndex);
+        }
+        return signature;
+    }
+}
+
 // コンストラクタ
 ChunkManager::ChunkManager(int chunkSize, int renderDistanceXZ, unsigned int noiseSeed, float noiseScale,
                            int worldMaxHeight, int groundLevel, int octaves, float lacunarity, float persistence)
@@ -16,127 +57,601 @@ ChunkManager::ChunkManager(int chunkSize, int renderDistanceXZ, unsigned int noi
                                                         std::make_unique<TerrainGenerator>(noiseSeed, noiseScale,
                                                                                            worldMaxHeight, groundLevel,
                                                                                            octaves, lacunarity, persistence))),
-      m_lastPlayerChunkCoord(std::numeric_limits<int>::max())
+      m_threadPool(std::make_unique<ThreadPool>()),
+      m_chunkGrid(2 * renderDistanceXZ + 1),
+      m_lastPlayerChunkCoord(std::numeric_limits<int>::max()),
+      m_priorityCenter(std::numeric_limits<int>::max()),
+      m_priorityForward(0.0f),
+      m_jobsInFlight(0),
+      m_gpuWorkBudget(TARGET_FRAME_SECONDS, MIN_GPU_WORK_BUDGET_SECONDS, MAX_GPU_WORK_BUDGET_SECONDS),
+      m_uploadCost(INITIAL_UPLOAD_SECONDS_PER_VERTEX),
+      m_releaseCost(INITIAL_RELEASE_SECONDS),
+      m_defragmentCost(INITIAL_DEFRAGMENT_SECONDS_PER_BYTE)
 {
+    buildOffsetTables();
+
     std::cout << "ChunkManager constructor called. ChunkSize: " << m_chunkSize
-              << ", RenderDistance: " << m_renderDistance << std::endl;
+              << ", RenderDistance: " << m_renderDistance
+              << ", WorkerThreads: " << m_threadPool->getThreadCount() << std::endl;
 }
 
 // デストラクタ (変更なし)
 ChunkManager::~ChunkManager()
 {
     std::cout << "ChunkManager destructor called." << std::endl;
-    // 待機中の非同期タスクがあればキャンセルまたは待機 (今回は簡単のため省略)
-    m_chunkRenderData.clear();
+    // 実行中のジョブは this と m_chunkProcessor を参照するので、他のメンバーより先にワーカーを停止する
+    // (未実行のジョブは破棄される)
+    m_threadPool.reset();
+    for (ChunkSlot *slot : m_activeSlots)
+    {
+        if (slot->chunk)
+        {
+            slot->chunk->setChangeListener(nullptr); // 外部で保持されているチャンクから通知されないようにする
+        }
+    }
+    m_activeSlots.clear();
 }
 
 // プレイヤーの位置に基づいてチャンクを更新（ロード/アンロード/メッシュ更新）
-void ChunkManager::update(const glm::vec3 &playerPosition)
+void ChunkManager::update(const glm::vec3 &playerPosition, const Frustum &viewFrustum, float lastFrameWorkSeconds)
 {
     glm::ivec3 currentChunkCoord = getChunkCoordFromWorldPos(playerPosition);
+    // 以降に追加するジョブの優先度もこの中心と視錐台で求める
+    updateJobPriorities(currentChunkCoord, viewFrustum);
 
     if (currentChunkCoord != m_lastPlayerChunkCoord)
     {
-        loadChunksInArea(currentChunkCoord);
-        unloadDistantChunks(currentChunkCoord);
+        updateLoadedArea(m_lastPlayerChunkCoord, currentChunkCoord);
         m_lastPlayerChunkCoord = currentChunkCoord;
     }
 
     // 完了したチャンク生成タスクの結果を処理
-    auto it_chunk_gen = m_pendingChunkGenerations.begin();
-    while (it_chunk_gen != m_pendingChunkGenerations.end())
-    {
-        if (it_chunk_gen->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    m_completedChunkGenerations.drain(
+        [this](CompletedChunkGeneration &&completed)
         {
-            glm::ivec3 chunkCoord = it_chunk_gen->first;
-            std::shared_ptr<Chunk> newChunk = it_chunk_gen->second.get();
-
-            if (newChunk)
+            --m_jobsInFlight;
+            if (!completed.cancellation.isCancelled()) // キャンセル済みならスロットは既に空いている
             {
-                m_chunks[chunkCoord] = newChunk;
-                newChunk->setDirty(true);
+                onChunkGenerated(*findSlot(completed.chunkCoord), std::move(completed.chunk));
+            }
+        });
 
-                // 新しく生成されたチャンクの隣接チャンクをダーティにする
-                for (int i = 0; i < 6; ++i)
-                {
-                    glm::ivec3 offset = neighborOffsets[i];
-                    glm::ivec3 neighborCoord = chunkCoord + offset;
-                    std::shared_ptr<Chunk> neighborChunk = getChunk(neighborCoord);
-                    if (neighborChunk)
-                    {
-                        neighborChunk->setDirty(true);
-                    }
-                }
+    // 変化があったチャンクだけをメッシュ生成待ちに加える
+    processDirtyChunks(currentChunkCoord);
+
+    // 完了したメッシュ生成タスクの結果を受け取る (ワーカーは次のジョブに進める)
+    m_completedMeshGenerations.drain(
+        [this](CompletedMeshGeneration &&completed)
+        {
+            --m_jobsInFlight;
+            if (!completed.cancellation.isCancelled())
+            {
+                m_meshesToUpload.push_back(std::move(completed));
             }
-            it_chunk_gen = m_pendingChunkGenerations.erase(it_chunk_gen);
+        });
+
+    // 待ち行列のジョブを優先度順にワーカーへ投入
+    dispatchQueuedJobs();
+
+    // 受け取ったメッシュの転送と、不要になった描画データの削除 (OpenGLリソース更新はメインスレッドで行う)
+    processGpuWork(lastFrameWorkSeconds);
+}
+
+// メッシュの転送と描画データの削除を、フレームあたりの時間予算の範囲で行う
+// 各作業の所要時間を計測して見積もりを更新し、予算を超えそうな作業は次のフレームに回す。
+// 大きなメッシュでも進むよう、転送と削除はそれぞれ毎フレーム最低1つは行う。
+void ChunkManager::processGpuWork(float lastFrameWorkSeconds)
+{
+    m_gpuWorkBudget.beginFrame(lastFrameWorkSeconds);
+    // 削除待ちがあれば予算の一部を削除用に残す (ストリーミング中に転送だけで予算を使い切り、削除待ちが溜まり続けないように)
+    const double reservedForReleases =
+        m_renderDataToRelease.empty() ? 0.0 : m_gpuWorkBudget.getBudgetSeconds() * RELEASE_BUDGET_SHARE;
+
+    int uploadsThisFrame = 0;
+    while (!m_meshesToUpload.empty())
+    {
+        CompletedMeshGeneration &completed = m_meshesToUpload.front();
+        if (completed.cancellation.isCancelled())
+        {
+            m_meshesToUpload.pop_front(); // 待っている間にアンロードされた
+            continue;
         }
-        else
+        double vertexCount = static_cast<double>(completed.meshData.vertices.size());
+        if (uploadsThisFrame > 0 &&
+            !m_gpuWorkBudget.canAfford(m_uploadCost.estimate(vertexCount) + reservedForReleases))
         {
-            ++it_chunk_gen;
+            break;
         }
+
+        double startSeconds = m_gpuWorkBudget.getElapsedSeconds();
+        onMeshGenerated(*findSlot(completed.chunkCoord), completed.meshData);
+        m_uploadCost.record(vertexCount, m_gpuWorkBudget.getElapsedSeconds() - startSeconds);
+        m_meshesToUpload.pop_front();
+        uploadsThisFrame++;
     }
 
-    // ダーティなチャンクのメッシュ生成を非同期で開始
-    std::vector<glm::ivec3> chunksToProcessMesh;
-    for (auto &pair : m_chunks)
+    // 削除は見た目に影響しないので、転送の後に残った予算 (削除用に残した分を含む) で行う
+    int releasesThisFrame = 0;
+    while (!m_renderDataToRelease.empty())
     {
-        if (pair.second->isDirty() && m_pendingMeshGenerations.find(pair.first) == m_pendingMeshGenerations.end())
+        if (releasesThisFrame > 0 && !m_gpuWorkBudget.canAfford(m_releaseCost.estimate(1.0)))
         {
-            chunksToProcessMesh.push_back(pair.first);
-            pair.second->setDirty(false);
+            break;
         }
+        double startSeconds = m_gpuWorkBudget.getElapsedSeconds();
+        m_renderDataToRelease.pop_back(); // デストラクタで共有頂点バッファの領域を返す
+        m_releaseCost.record(1.0, m_gpuWorkBudget.getElapsedSeconds() - startSeconds);
+        releasesThisFrame++;
+    }
+
+    // さらに余った予算で共有頂点バッファの隙間を詰める (断片化で新しいページが増えるのを防ぐ)
+    // 削除待ちが残っている間は行わない (すぐに解放されるメッシュをコピーしてしまうため。解放で隙間も変わる)
+    if (!m_renderDataToRelease.empty())
+    {
+        return;
+    }
+    size_t defragmentedBytes = 0;
+    while (defragmentedBytes < MAX_DEFRAGMENT_BYTES_PER_FRAME)
+    {
+        double affordableBytes = m_gpuWorkBudget.getRemainingSeconds() / std::max(m_defragmentCost.estimate(1.0), 1.0e-15);
+        size_t maxBytes = static_cast<size_t>(
+            std::clamp(affordableBytes, 0.0, static_cast<double>(MAX_DEFRAGMENT_BYTES_PER_FRAME - defragmentedBytes)));
+        double startSeconds = m_gpuWorkBudget.getElapsedSeconds();
+        size_t movedBytes = maxBytes > 0 ? ChunkRenderer::defragmentMeshes(maxBytes) : 0;
+        if (movedBytes == 0)
+        {
+            break;
+        }
+        m_defragmentCost.record(static_cast<double>(movedBytes), m_gpuWorkBudget.getElapsedSeconds() - startSeconds);
+        defragmentedBytes += movedBytes;
+    }
+}
+
+// スロットの描画データを外し、削除待ちに回す
+void ChunkManager::releaseRenderData(ChunkSlot &slot)
+{
+    removeFromCuller(slot);
+    if (slot.renderData.hasMesh())
+    {
+        m_renderDataToRelease.push_back(std::move(slot.renderData));
+    }
+    slot.renderData = ChunkRenderData();
+}
+
+// メッシュの AABB をワールド座標にしてカリング対象に加える
+void ChunkManager::addToCuller(ChunkSlot &slot)
+{
+    glm::ivec3 origin = slot.coord * m_chunkSize;
+    slot.cullIndex = m_chunkCuller.add(static_cast<glm::vec3>(origin + slot.renderData.boundsMin),
+                                       static_cast<glm::vec3>(origin + slot.renderData.boundsMax));
+    m_culledSlots.push_back(&slot);
+}
+
+// カリング対象から外す (ChunkCuller と同じく末尾の要素と入れ替えて削除する)
+void ChunkManager::removeFromCuller(ChunkSlot &slot)
+{
+    if (slot.cullIndex == ChunkSlot::NOT_CULLED)
+    {
+        return;
+    }
+    m_chunkCuller.remove(slot.cullIndex);
+    ChunkSlot *lastSlot = m_culledSlots.back();
+    m_culledSlots[slot.cullIndex] = lastSlot;
+    lastSlot->cullIndex = slot.cullIndex;
+    m_culledSlots.pop_back();
+    slot.cullIndex = ChunkSlot::NOT_CULLED;
+}
+
+// 生成ジョブの完了: Generating → Loaded
+void ChunkManager::onChunkGenerated(ChunkSlot &slot, std::shared_ptr<Chunk> chunk)
+{
+    if (!chunk)
+    {
+        unloadChunk(slot.coord); // 生成が中断された
+        return;
     }
+    slot.chunk = std::move(chunk);
+    slot.state = ChunkState::Loaded;
+    // 以降の編集は onChunkDirty で通知される (生成時の変更はここでまとめて扱う)
+    slot.chunk->setChangeListener(this);
+    slot.chunk->setDirty(false);
+    markChunkDirty(slot);
+
+    // 新しく生成されたチャンクの隣接チャンクをダーティにする
+    // (接する境界が全て空気なら、近傍のメッシュは変わらないので作り直さない)
+    markNeighborsDirtyIfBorderChanged(slot.coord);
+}
 
-    for (const auto &chunkCoord : chunksToProcessMesh)
+// メッシュ生成ジョブの完了: Meshing → Loaded
+void ChunkManager::onMeshGenerated(ChunkSlot &slot, const ChunkMeshData &meshData)
+{
+    // 既存のメッシュの領域は削除待ちに回す (インデックスバッファは共有なので削除しない)
+    // メッシュデータが空の場合は描画データなしになる
+    releaseRenderData(slot);
+    slot.renderData = ChunkRenderer::createChunkRenderData(meshData);
+    if (slot.renderData.hasMesh())
     {
-        std::shared_ptr<Chunk> chunk = m_chunks[chunkCoord];
+        addToCuller(slot);
+    }
+    slot.state = ChunkState::Loaded;
 
-        // ChunkProcessor の generateMeshForChunk を非同期で実行
-        // this を NeighborChunkProvider* として渡す
-        m_pendingMeshGenerations[chunkCoord] = std::async(std::launch::async,
-                                                          &ChunkProcessor::generateMeshForChunk,
-                                                          m_chunkProcessor.get(),   // ChunkProcessor のインスタンス
-                                                          chunkCoord, chunk, this); // this は NeighborChunkProvider*
+    // 生成中に変化があった場合は、途中の変更をまとめて1回だけ作り直す
+    if (slot.meshVersion != slot.voxelVersion)
+    {
+        queueDirtyCheck(slot);
     }
+}
+
+// ロード済みのチャンクが編集された (Chunk::setDirty から呼ばれる)
+void ChunkManager::onChunkDirty(Chunk &chunk)
+{
+    ChunkSlot *slot = findSlot(chunk.getCoord());
+    if (slot && slot->chunk.get() == &chunk)
+    {
+        markChunkDirty(*slot);
+    }
+}
+
+// チャンクの内容か、メッシュに影響する近傍が変化した
+void ChunkManager::markChunkDirty(ChunkSlot &slot)
+{
+    ++slot.voxelVersion;
+    queueDirtyCheck(slot);
+}
 
-    // 完了したメッシュ生成タスクの結果を処理 (OpenGLリソース更新はメインスレッドで行う)
-    const int MAX_MESH_UPDATES_PER_FRAME = 1;
-    int updatesThisFrame = 0;
+// 次の processDirtyChunks でメッシュ生成が必要かを確認する
+void ChunkManager::queueDirtyCheck(ChunkSlot &slot)
+{
+    if (!slot.isInDirtyList)
+    {
+        slot.isInDirtyList = true;
+        m_dirtyChunks.push_back(slot.coord);
+    }
+}
 
-    auto it_mesh_gen = m_pendingMeshGenerations.begin();
-    while (it_mesh_gen != m_pendingMeshGenerations.end() && updatesThisFrame < MAX_MESH_UPDATES_PER_FRAME)
+// メッシュが古くなったチャンクをメッシュ生成待ちにする: Loaded → MeshQueued
+// 生成待ち・生成中のチャンクは、投入時・完了時に最新の版数を見るのでここでは何もしない
+void ChunkManager::processDirtyChunks(const glm::ivec3 &centerChunkCoord)
+{
+    std::vector<glm::ivec3> dirtyChunks;
+    dirtyChunks.swap(m_dirtyChunks);
+    for (const glm::ivec3 &chunkCoord : dirtyChunks)
     {
-        if (it_mesh_gen->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        ChunkSlot *slot = findSlot(chunkCoord);
+        if (!slot || !slot->isInDirtyList)
         {
-            glm::ivec3 chunkCoord = it_mesh_gen->first;
-            ChunkMeshData meshData = it_mesh_gen->second.get();
+            continue; // 登録後にアンロードされた
+        }
+        slot->isInDirtyList = false;
 
-            updateChunkRenderData(chunkCoord, meshData);
-            it_mesh_gen = m_pendingMeshGenerations.erase(it_mesh_gen);
-            updatesThisFrame++;
+        // 編集されたチャンクは、このフレームまでの編集をまとめた後の境界で近傍の作り直しを判定する
+        // (ダーティフラグを下ろすと、次の編集で再び通知される)
+        if (slot->chunk && slot->chunk->isDirty())
+        {
+            slot->chunk->setDirty(false);
+            markNeighborsDirtyIfBorderChanged(chunkCoord);
         }
-        else
+
+        if (slot->state != ChunkState::Loaded || slot->meshVersion == slot->voxelVersion)
         {
-            ++it_mesh_gen;
+            continue;
         }
+
+        // 一様なチャンクで面が1つも出ないことが分かっている場合はメッシュ生成を行わない
+        if (!needsMeshGeneration(chunkCoord, *slot->chunk))
+        {
+            slot->meshVersion = slot->voxelVersion;
+            slot->hasMeshNeighborSignatures = false; // 近傍が変化したら改めて判定する
+            releaseRenderData(*slot);
+            continue;
+        }
+
+        // 近傍が揃うまでは古いまま待つ (近傍の生成・アンロード時に改めて確認される)
+        // (近傍が届くたびにメッシュを作り直すと、ストリーミング中は1チャンクにつき最大7回生成されてしまう)
+        if (!areNeighborsSettled(chunkCoord, centerChunkCoord))
+        {
+            continue;
+        }
+        slot->state = ChunkState::MeshQueued;
+        queueJob(chunkCoord, true);
     }
 }
 
 // 指定されたワールド座標のチャンクが存在するかどうかをチェックします (変更なし)
 bool ChunkManager::hasChunk(const glm::ivec3 &chunkCoord) const
 {
-    return m_chunks.count(chunkCoord) > 0;
+    const ChunkSlot *slot = findSlot(chunkCoord);
+    return slot && slot->chunk;
 }
 
 // 指定されたチャンク座標のチャンクを取得します (NeighborChunkProvider のオーバーライド)
-std::shared_ptr<Chunk> ChunkManager::getChunk(const glm::ivec3 &chunkCoord)
+std::shared_ptr<const Chunk> ChunkManager::getChunk(const glm::ivec3 &chunkCoord)
+{
+    ChunkSlot *slot = findSlot(chunkCoord);
+    return slot ? slot->chunk : nullptr;
+}
+
+// editChunk 用に、スロットのチャンクを複製して差し替える (ロードされていなければ nullptr)
+// 元のチャンクはメッシュ生成ジョブ (自身・近傍のスナップショット) が参照している間そのまま残る
+std::shared_ptr<Chunk> ChunkManager::cloneChunkForEdit(const glm::ivec3 &chunkCoord)
 {
-    auto it = m_chunks.find(chunkCoord);
-    if (it != m_chunks.end())
+    ChunkSlot *slot = findSlot(chunkCoord);
+    if (!slot || !slot->chunk)
     {
-        return it->second;
+        return nullptr;
     }
-    return nullptr;
+    std::shared_ptr<Chunk> clone = std::make_shared<Chunk>(*slot->chunk); // 変更通知先 (this) も引き継ぐ
+    slot->chunk->setChangeListener(nullptr);
+    slot->chunk = clone;
+    return clone;
+}
+
+// chunkCoord が使用しているスロット (使用していなければ nullptr)
+// 同じスロットを共有する別の座標 (ロード範囲の直径だけ離れた座標) とは coord で区別する
+ChunkSlot *ChunkManager::findSlot(const glm::ivec3 &chunkCoord)
+{
+    ChunkSlot &slot = m_chunkGrid.at(chunkCoord);
+    return (slot.state != ChunkState::Empty && slot.coord == chunkCoord) ? &slot : nullptr;
+}
+
+const ChunkSlot *ChunkManager::findSlot(const glm::ivec3 &chunkCoord) const
+{
+    const ChunkSlot &slot = m_chunkGrid.at(chunkCoord);
+    return (slot.state != ChunkState::Empty && slot.coord == chunkCoord) ? &slot : nullptr;
+}
+
+// chunkCoord のためにスロットを確保する (状態は呼び出し側で設定する)
+// ロード範囲外のチャンクは先にアンロードしているので、通常は空いている
+ChunkSlot &ChunkManager::claimSlot(const glm::ivec3 &chunkCoord)
+{
+    ChunkSlot &slot = m_chunkGrid.at(chunkCoord);
+    if (slot.state != ChunkState::Empty)
+    {
+        std::cerr << "ChunkManager: slot for " << chunkCoord.x << ", " << chunkCoord.y << ", " << chunkCoord.z
+                  << " is still used by " << slot.coord.x << ", " << slot.coord.y << ", " << slot.coord.z
+                  << ". Unloading it." << std::endl;
+        unloadChunk(slot.coord);
+    }
+    slot.coord = chunkCoord;
+    slot.meshVersion = slot.voxelVersion;
+    slot.activeIndex = m_activeSlots.size();
+    m_activeSlots.push_back(&slot);
+    return slot;
+}
+
+// 26 近傍のうち、chunkCoord のチャンクとの境界がメッシュ生成時から変化したものをダーティにする
+// chunkCoord のチャンクの生成・アンロード後に呼ぶ (アンロード時はスロットを空けた後)
+// 近傍が揃うのを待っている (メッシュが古い) チャンクは、境界が変わらなくても改めて確認させる
+// AO は辺・角で接するチャンクのボクセルも参照するため、面で接するチャンクだけでは足りない
+void ChunkManager::markNeighborsDirtyIfBorderChanged(const glm::ivec3 &chunkCoord)
+{
+    std::shared_ptr<const Chunk> chunk = getChunk(chunkCoord);
+    for (int dz = -1; dz <= 1; ++dz)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                if (dx == 0 && dy == 0 && dz == 0)
+                {
+                    continue;
+                }
+                glm::ivec3 neighborCoord = chunkCoord + glm::ivec3(dx, dy, dz);
+                ChunkSlot *neighborSlot = findSlot(neighborCoord);
+                if (!neighborSlot || !neighborSlot->chunk)
+                {
+                    continue;
+                }
+
+                // 近傍から見た chunkCoord のオフセットは (-dx, -dy, -dz)
+                glm::ivec3 offsetFromNeighbor(-dx, -dy, -dz);
+                if (!neighborSlot->hasMeshNeighborSignatures ||
+                    (*neighborSlot->meshNeighborSignatures)[chunkNeighborhoodIndex(offsetFromNeighbor)] !=
+                        getFacingBorderSignature(chunk.get(), offsetFromNeighbor))
+                {
+                    markChunkDirty(*neighborSlot);
+                }
+                else if (neighborSlot->meshVersion != neighborSlot->voxelVersion)
+                {
+                    queueDirtyCheck(*neighborSlot);
+                }
+            }
+        }
+    }
+}
+
+// 一様なチャンクのうち、面が生成されないものを判定する
+// 全て空気なら面はなく、全てソリッドなら6方向の隣接チャンクも全てソリッドの場合に面はない
+// (存在しない隣接チャンクは空気として扱われるので、その方向には面が出る)
+bool ChunkManager::needsMeshGeneration(const glm::ivec3 &chunkCoord, const Chunk &chunk)
+{
+    if (!chunk.isUniform())
+    {
+        return true;
+    }
+    if (chunk.isUniformAir())
+    {
+        return false;
+    }
+    for (int i = 0; i < 6; ++i)
+    {
+        std::shared_ptr<const Chunk> neighborChunk = getChunk(chunkCoord + neighborOffsets[i]);
+        if (!neighborChunk || !neighborChunk->isUniformSolid())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 待ち行列のジョブを追加する (既に待っている場合は何もしない)
+void ChunkManager::queueJob(const glm::ivec3 &chunkCoord, bool isMeshJob)
+{
+    std::unordered_set<glm::ivec3, Vec3iHash> &queued = isMeshJob ? m_queuedMeshGenerations : m_queuedChunkGenerations;
+    if (!queued.insert(chunkCoord).second)
+    {
+        return;
+    }
+    m_jobQueue.push_back({getJobPriority(chunkCoord), chunkCoord, isMeshJob});
+    std::push_heap(m_jobQueue.begin(), m_jobQueue.end(), QueuedJob::isLowerPriority);
+}
+
+// 中心のチャンクが変わったか、視線の向きがしきい値より大きく変わったときだけ、待っている全ジョブの優先度を求め直す
+// (取り出し済み・キャンセル済みの要素もここで取り除く)
+void ChunkManager::updateJobPriorities(const glm::ivec3 &centerChunkCoord, const Frustum &viewFrustum)
+{
+    glm::vec3 forward = viewFrustum.getForward();
+    bool headingChanged = glm::dot(forward, m_priorityForward) < PRIORITY_HEADING_COS_THRESHOLD &&
+                          glm::dot(forward, forward) > 0.0f;
+    size_t queuedCount = m_queuedChunkGenerations.size() + m_queuedMeshGenerations.size();
+    bool tooManyStale = m_jobQueue.size() > queuedCount * 2 + 64;
+    if (centerChunkCoord == m_priorityCenter && !headingChanged && !tooManyStale)
+    {
+        return;
+    }
+
+    m_priorityCenter = centerChunkCoord;
+    m_priorityForward = forward;
+    m_priorityFrustum = viewFrustum;
+    m_jobQueue.clear();
+    m_jobQueue.reserve(queuedCount);
+    for (const glm::ivec3 &coord : m_queuedChunkGenerations)
+    {
+        m_jobQueue.push_back({getJobPriority(coord), coord, false});
+    }
+    for (const glm::ivec3 &coord : m_queuedMeshGenerations)
+    {
+        m_jobQueue.push_back({getJobPriority(coord), coord, true});
+    }
+    std::make_heap(m_jobQueue.begin(), m_jobQueue.end(), QueuedJob::isLowerPriority);
+}
+
+// 実行待ちのジョブを優先度の高い順に、同時実行数の上限までワーカーへ投入する
+// 投入済みのジョブは順序を変えられないので、同時実行数を絞ってワーカーのキューを浅く保つ。
+// 空いている件数だけヒープから取り出すので、待ち行列の長さによらず投入する件数分の手間で済む。
+void ChunkManager::dispatchQueuedJobs()
+{
+    const size_t maxJobsInFlight = std::max<size_t>(4, m_threadPool->getThreadCount() * 2);
+    while (m_jobsInFlight < maxJobsInFlight && !m_jobQueue.empty())
+    {
+        std::pop_heap(m_jobQueue.begin(), m_jobQueue.end(), QueuedJob::isLowerPriority);
+        QueuedJob job = m_jobQueue.back();
+        m_jobQueue.pop_back();
+
+        const glm::ivec3 &chunkCoord = job.chunkCoord;
+        std::unordered_set<glm::ivec3, Vec3iHash> &queued =
+            job.isMeshJob ? m_queuedMeshGenerations : m_queuedChunkGenerations;
+        if (queued.erase(chunkCoord) == 0)
+        {
+            continue; // 投入済みか、アンロードで取り消された
+        }
+
+        if (!job.isMeshJob)
+        {
+            // ChunkProcessor の generateChunkData をワーカースレッドで実行: GenerationQueued → Generating
+            ChunkSlot &slot = *findSlot(chunkCoord);
+            slot.state = ChunkState::Generating;
+            slot.jobCancellation = CancellationToken::create();
+            m_threadPool->execute(
+                [this, chunkCoord, cancellation = slot.jobCancellation]()
+                {
+                    std::shared_ptr<Chunk> chunk = m_chunkProcessor->generateChunkData(chunkCoord, cancellation);
+                    m_completedChunkGenerations.push({chunkCoord, cancellation, std::move(chunk)});
+                });
+            ++m_jobsInFlight;
+            continue;
+        }
+
+        ChunkSlot *slot = findSlot(chunkCoord);
+        // MeshQueued → Meshing (待っている間の変更も含めた最新の版数でメッシュを作る)
+        slot->state = ChunkState::Meshing;
+        slot->meshVersion = slot->voxelVersion;
+        // 近傍はここ (メインスレッド) でスナップショットとして渡す
+        // ワーカーからチャンクのグリッドを参照すると、メインスレッドでの挿入・削除と競合するため
+        ChunkNeighborSnapshot neighbors = ChunkProcessor::collectNeighbors(chunkCoord, this);
+
+        // このメッシュが参照する近傍の境界を記録する
+        if (!slot->meshNeighborSignatures)
+        {
+            slot->meshNeighborSignatures = std::make_unique<NeighborBorderSignatures>();
+        }
+        NeighborBorderSignatures &signatures = *slot->meshNeighborSignatures;
+        slot->hasMeshNeighborSignatures = true;
+        for (int dz = -1; dz <= 1; ++dz)
+        {
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    glm::ivec3 offset(dx, dy, dz);
+                    int index = chunkNeighborhoodIndex(offset);
+                    signatures[index] = getFacingBorderSignature(neighbors[index].get(), offset);
+                }
+            }
+        }
+
+        // ChunkProcessor の generateMeshForChunk をワーカースレッドで実行
+        slot->jobCancellation = CancellationToken::create();
+        m_threadPool->execute(
+            [this, chunkCoord, chunk = std::shared_ptr<const Chunk>(slot->chunk), neighbors = std::move(neighbors),
+             cancellation = slot->jobCancellation]()
+            {
+                ChunkMeshData meshData =
+                    m_chunkProcessor->generateMeshForChunk(chunkCoord, chunk, neighbors, cancellation);
+                m_completedMeshGenerations.push({chunkCoord, cancellation, std::move(meshData)});
+            });
+        ++m_jobsInFlight;
+    }
+}
+
+// ジョブの優先度 (小さいほど先に実行する)
+// プレイヤーのチャンクからの距離の2乗を基本とし、視錐台の外のチャンクは距離を2倍として扱う
+float ChunkManager::getJobPriority(const glm::ivec3 &chunkCoord) const
+{
+    const float OUT_OF_VIEW_DISTANCE_SCALE = 2.0f;
+
+    glm::vec3 offset = static_cast<glm::vec3>(chunkCoord - m_priorityCenter);
+    float priority = glm::dot(offset, offset);
+
+    glm::vec3 minPoint = static_cast<glm::vec3>(chunkCoord * m_chunkSize);
+    glm::vec3 maxPoint = minPoint + glm::vec3(static_cast<float>(m_chunkSize));
+    if (!m_priorityFrustum.isBoxVisible(minPoint, maxPoint))
+    {
+        priority *= OUT_OF_VIEW_DISTANCE_SCALE * OUT_OF_VIEW_DISTANCE_SCALE;
+    }
+    return priority;
+}
+
+// チャンクがロード範囲 (中心からの球) の内側にあるか
+bool ChunkManager::isWithinRenderDistance(const glm::ivec3 &chunkCoord, const glm::ivec3 &centerChunkCoord) const
+{
+    glm::ivec3 offset = chunkCoord - centerChunkCoord;
+    return offset.x * offset.x + offset.y * offset.y + offset.z * offset.z <= m_renderDistance * m_renderDistance;
+}
+
+// 26 近傍が全てボクセルデータを持っているか、ロード範囲外で今後ロードされないかを判定する
+// これが満たされる前にメッシュを作っても、近傍の到着で作り直しになる
+bool ChunkManager::areNeighborsSettled(const glm::ivec3 &chunkCoord, const glm::ivec3 &centerChunkCoord) const
+{
+    for (int dz = -1; dz <= 1; ++dz)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                glm::ivec3 neighborCoord = chunkCoord + glm::ivec3(dx, dy, dz);
+                if ((dx == 0 && dy == 0 && dz == 0) || hasChunk(neighborCoord))
+                {
+                    continue;
+                }
+                if (isWithinRenderDistance(neighborCoord, centerChunkCoord))
+                {
+                    return false; // まだ生成されていない
+                }
+            }
+        }
+    }
+    return true;
 }
 
 // ワールド座標からチャンク座標を計算するヘルパー関数 (変更なし)
@@ -147,28 +662,51 @@ glm::ivec3 ChunkManager::getChunkCoordFromWorldPos(const glm::vec3 &worldPos) co
                       std::floor(worldPos.z / m_chunkSize));
 }
 
-// プレイヤーを中心としたエリア内のチャンクをロード（存在しない場合は生成）
-void ChunkManager::loadChunksInArea(const glm::ivec3 &centerChunkCoord)
+// ロード範囲 (半径 m_renderDistance の球) のオフセット表と、中心が1チャンク移動したときの差分を事前計算する
+void ChunkManager::buildOffsetTables()
 {
-    for (int y_offset = -m_renderDistance; y_offset <= m_renderDistance; ++y_offset)
+    const int r = m_renderDistance;
+    m_sphereOffsets.clear();
+    for (int y = -r; y <= r; ++y)
     {
-        for (int x_offset = -m_renderDistance; x_offset <= m_renderDistance; ++x_offset)
+        for (int z = -r; z <= r; ++z)
         {
-            for (int z_offset = -m_renderDistance; z_offset <= m_renderDistance; ++z_offset)
+            for (int x = -r; x <= r; ++x)
             {
-                // 中心チャンクからの距離を計算 (球形にするための変更点)
-                float distance = std::sqrt(static_cast<float>(x_offset * x_offset + y_offset * y_offset + z_offset * z_offset));
+                glm::ivec3 offset(x, y, z);
+                if (isWithinRenderDistance(offset, glm::ivec3(0)))
+                {
+                    m_sphereOffsets.push_back(offset);
+                }
+            }
+        }
+    }
+    // 近い順に並べる (ロード要求も近い順に行われる)
+    std::stable_sort(m_sphereOffsets.begin(), m_sphereOffsets.end(),
+                     [](const glm::ivec3 &a, const glm::ivec3 &b)
+                     { return a.x * a.x + a.y * a.y + a.z * a.z < b.x * b.x + b.y * b.y + b.z * b.z; });
 
-                // 距離がレンダリング距離内であればロード
-                if (distance <= m_renderDistance)
+    // 中心が delta だけ動いたときに新しく範囲に入るオフセット (新しい中心からの相対位置)
+    // 範囲から出るオフセット (古い中心からの相対位置) は -delta の場合の入るオフセットと一致する
+    for (int dz = -1; dz <= 1; ++dz)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                glm::ivec3 delta(dx, dy, dz);
+                std::vector<glm::ivec3> &entering = m_enteringShells[chunkNeighborhoodIndex(delta)];
+                entering.clear();
+                if (delta == glm::ivec3(0))
+                {
+                    continue;
+                }
+                for (const glm::ivec3 &offset : m_sphereOffsets)
                 {
-                    glm::ivec3 chunkCoord = centerChunkCoord + glm::ivec3(x_offset, y_offset, z_offset);
-                    if (!hasChunk(chunkCoord) && m_pendingChunkGenerations.find(chunkCoord) == m_pendingChunkGenerations.end())
+                    // 古い中心からの相対位置は offset + delta
+                    if (!isWithinRenderDistance(offset + delta, glm::ivec3(0)))
                     {
-                        // ChunkProcessor の generateChunkData を非同期で実行
-                        m_pendingChunkGenerations[chunkCoord] = std::async(std::launch::async,
-                                                                           &ChunkProcessor::generateChunkData,
-                                                                           m_chunkProcessor.get(), chunkCoord);
+                        entering.push_back(offset);
                     }
                 }
             }
@@ -176,69 +714,107 @@ void ChunkManager::loadChunksInArea(const glm::ivec3 &centerChunkCoord)
     }
 }
 
-// 描画距離外に出たチャンクをアンロード (変更なし)
-void ChunkManager::unloadDistantChunks(const glm::ivec3 &centerChunkCoord)
+// ロード範囲の中心の移動に合わせてチャンクをロード・アンロードする
+// 隣接チャンク (斜めを含む) への移動なら、出入りする殻の部分だけを処理する。
+// それより大きく移動した場合 (初回やテレポート) は範囲全体を走査し直す。
+void ChunkManager::updateLoadedArea(const glm::ivec3 &previousCenter, const glm::ivec3 &centerChunkCoord)
 {
-    std::vector<glm::ivec3> chunksToUnload;
-    for (auto const &[coord, chunk] : m_chunks)
+    // 初回は前回の中心が番兵値 (int の最大値) になっている
+    bool hasPreviousCenter = previousCenter != glm::ivec3(std::numeric_limits<int>::max());
+    glm::ivec3 delta = hasPreviousCenter ? centerChunkCoord - previousCenter : glm::ivec3(0);
+    bool isSingleStep = hasPreviousCenter &&
+                        std::abs(delta.x) <= 1 && std::abs(delta.y) <= 1 && std::abs(delta.z) <= 1;
+    if (!isSingleStep)
+    {
+        unloadDistantChunks(centerChunkCoord);
+        loadChunksInArea(centerChunkCoord);
+        return;
+    }
 
+    // 先にアンロードしてから、新しく入った部分を要求する
+    for (const glm::ivec3 &offset : m_enteringShells[chunkNeighborhoodIndex(-delta)])
     {
-        int dist_x = std::abs(coord.x - centerChunkCoord.x);
-        int dist_y = std::abs(coord.y - centerChunkCoord.y);
-        int dist_z = std::abs(coord.z - centerChunkCoord.z);
+        unloadChunk(previousCenter + offset);
+    }
+    for (const glm::ivec3 &offset : m_enteringShells[chunkNeighborhoodIndex(delta)])
+    {
+        requestChunk(centerChunkCoord + offset);
+    }
+}
 
-        // 球形アンロードの場合も、距離計算を調整
-        float distance = std::sqrt(static_cast<float>(dist_x * dist_x + dist_y * dist_y + dist_z * dist_z));
+// プレイヤーを中心としたエリア内のチャンクをロード（存在しない場合は生成）
+void ChunkManager::loadChunksInArea(const glm::ivec3 &centerChunkCoord)
+{
+    for (const glm::ivec3 &offset : m_sphereOffsets)
+    {
+        requestChunk(centerChunkCoord + offset);
+    }
+}
 
-        if (distance > m_renderDistance) // レンダリング距離の外側であればアンロード
+// チャンクが未生成なら生成待ちに加える (実際の投入は dispatchQueuedJobs で優先度順に行う)
+void ChunkManager::requestChunk(const glm::ivec3 &chunkCoord)
+{
+    if (!findSlot(chunkCoord))
+    {
+        claimSlot(chunkCoord).state = ChunkState::GenerationQueued;
+        queueJob(chunkCoord, false);
+    }
+}
 
+// 描画距離外に出たチャンクを全て走査してアンロード
+void ChunkManager::unloadDistantChunks(const glm::ivec3 &centerChunkCoord)
+{
+    std::vector<glm::ivec3> chunksToUnload;
+    for (const ChunkSlot *slot : m_activeSlots)
+    {
+        if (!isWithinRenderDistance(slot->coord, centerChunkCoord))
         {
-            chunksToUnload.push_back(coord);
+            chunksToUnload.push_back(slot->coord);
         }
     }
+
     for (const auto &coord : chunksToUnload)
     {
-        // チャンクがアンロードされるときに、その隣接チャンク（まだ存在する場合）もダーティにする
-        for (int i = 0; i < 6; ++i)
-        {
-            glm::ivec3 offset = neighborOffsets[i];
-            glm::ivec3 neighborCoord = coord + offset;
-            std::shared_ptr<Chunk> neighborChunk = getChunk(neighborCoord);
-            if (neighborChunk)
-            {
-                neighborChunk->setDirty(true);
-            }
-        }
-
-        m_chunkRenderData.erase(coord);
-        m_chunks.erase(coord);
+        unloadChunk(coord);
     }
 }
 
-// OpenGLリソースの更新はメインスレッドで行う (変更なし)
-void ChunkManager::updateChunkRenderData(const glm::ivec3 &chunkCoord, const ChunkMeshData &meshData)
+// チャンクと、そのチャンクに関する待機中・実行中のジョブを全て破棄する: (任意の状態) → Empty
+void ChunkManager::unloadChunk(const glm::ivec3 &chunkCoord)
 {
-    auto it = m_chunkRenderData.find(chunkCoord);
-    if (it != m_chunkRenderData.end())
+    ChunkSlot *slot = findSlot(chunkCoord);
+    if (!slot)
     {
-        // 既存のVAO, VBO, EBOを削除
-        if (it->second.VAO != 0)
-            glDeleteVertexArrays(1, &it->second.VAO);
-        if (it->second.VBO != 0)
-            glDeleteBuffers(1, &it->second.VBO);
-        if (it->second.EBO != 0)
-            glDeleteBuffers(1, &it->second.EBO);
-        m_chunkRenderData.erase(it);
+        return;
     }
 
-    // 新しいレンダリングデータを生成
-    if (!meshData.vertices.empty() && !meshData.indices.empty())
+    // 範囲外になった生成待ちのチャンクは生成しない
+    m_queuedChunkGenerations.erase(chunkCoord);
+    m_queuedMeshGenerations.erase(chunkCoord);
+
+    // 実行中のジョブもキャンセルし、完了キューに届いた結果は破棄させる
+    if (slot->state == ChunkState::Generating || slot->state == ChunkState::Meshing)
     {
-        ChunkRenderData renderData = ChunkRenderer::createChunkRenderData(meshData);
-        m_chunkRenderData[chunkCoord] = std::move(renderData);
+        slot->jobCancellation.cancel();
     }
-    else
+
+    // m_activeSlots からは末尾と入れ替えて削除する
+    ChunkSlot *lastSlot = m_activeSlots.back();
+    m_activeSlots[slot->activeIndex] = lastSlot;
+    lastSlot->activeIndex = slot->activeIndex;
+    m_activeSlots.pop_back();
+
+    slot->state = ChunkState::Empty;
+    releaseRenderData(*slot); // メッシュの領域は後のフレームで返す
+    if (slot->chunk)
     {
-        // メッシュデータが空の場合の処理
+        slot->chunk->setChangeListener(nullptr); // メッシュ生成中のジョブがまだ参照している場合がある
+        slot->chunk.reset();
     }
-}
\ No newline at end of file
+    slot->isInDirtyList = false; // m_dirtyChunks に残った座標は処理時に読み飛ばされる
+    slot->hasMeshNeighborSignatures = false;
+
+    // チャンクがアンロードされるときに、その隣接チャンク（まだ存在する場合）もダーティにする
+    // (接していた境界が全て空気だった近傍は、見た目が変わらないので作り直さない)
+    markNeighborsDirtyIfBorderChanged(chunkCoord);
+}
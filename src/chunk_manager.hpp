@@ -1,39 +1,148 @@
 #ifndef CHUNK_MANAGER_HPP
 #define CHUNK_MANAGER_HPP
 
+#include <array>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <glm/glm.hpp>
-#include <future>
 #include <vector>
 #include "chunk/chunk.hpp"
 #include "chunk_mesh_generator.hpp" // ChunkMeshData の定義のため
 #include "chunk_renderer.hpp"
 #include "terrain_generator.hpp" // ChunkProcessor のコンストラクタに渡すため
 #include "chunk_processor.hpp" // 新しいクラスをインクルード
+#include "thread/thread_pool.hpp"
+#include "thread/cancellation_token.hpp"
+#include "thread/mpsc_queue.hpp"
+#include "frustum.hpp"
+#include "chunk_culler.hpp"
+#include "chunk/toroidal_grid.hpp"
+#include "time/frame_budget.hpp"
 
-// チャンクのワールド座標をキーとするハッシュ関数 (変更なし)
+// チャンクのワールド座標をキーとするハッシュ関数
+// 近い座標同士が衝突しないよう、各成分に大きな素数を掛けてから混ぜる
 struct Vec3iHash
 {
     size_t operator()(const glm::ivec3 &v) const
     {
-        return std::hash<int>()(v.x) ^ (std::hash<int>()(v.y) << 1) ^ (std::hash<int>()(v.z) << 2);
+        return static_cast<size_t>(static_cast<std::uint32_t>(v.x) * 73856093u ^
+                                   static_cast<std::uint32_t>(v.y) * 19349663u ^
+                                   static_cast<std::uint32_t>(v.z) * 83492791u);
     }
 };
 
-class ChunkManager : public NeighborChunkProvider // NeighborChunkProvider を実装
+// ワーカーが完了キューへ送るジョブの結果
+// チャンクが範囲外になったら cancellation でジョブに中断を伝え、届いた結果は破棄する
+struct CompletedChunkGeneration
+{
+    glm::ivec3 chunkCoord;
+    CancellationToken cancellation;
+    std::shared_ptr<Chunk> chunk;
+};
+
+struct CompletedMeshGeneration
+{
+    glm::ivec3 chunkCoord;
+    CancellationToken cancellation;
+    ChunkMeshData meshData;
+};
+
+// メッシュ生成時に参照した 26 近傍の境界のシグネチャ (インデックスは chunkNeighborhoodIndex)
+using NeighborBorderSignatures = std::array<std::uint64_t, 27>;
+
+// チャンクの状態
+// Empty → GenerationQueued → Generating → Loaded → MeshQueued → Meshing → Loaded → ...
+// どの状態からでもアンロードで Empty に戻る
+enum class ChunkState : std::uint8_t
+{
+    Empty,            // スロットは未使用
+    GenerationQueued, // 生成待ち (m_queuedChunkGenerations にある)
+    Generating,       // 生成ジョブを実行中
+    Loaded,           // ボクセルデータあり。メッシュが最新か、近傍が揃うのを待っている
+    MeshQueued,       // メッシュ生成待ち (m_queuedMeshGenerations にある)
+    Meshing,          // メッシュ生成ジョブを実行中
+};
+
+// ロード範囲内の1チャンク分の状態 (ToroidalGrid のスロット)
+// 生成要求からアンロードまで、coord のチャンクがこのスロットを占有する
+struct ChunkSlot
+{
+    glm::ivec3 coord{0};
+    ChunkState state = ChunkState::Empty;
+    std::shared_ptr<Chunk> chunk;
+    ChunkRenderData renderData;
+    // チャンク自身か近傍が変化するたびに増える版数と、現在の (または生成中の) メッシュの元になった版数
+    // 両者が異なる間はメッシュが古い
+    std::uint32_t voxelVersion = 0;
+    std::uint32_t meshVersion = 0;
+    bool isInDirtyList = false; // m_dirtyChunks に登録済み (重複登録しない)
+    // 現在の (または生成中の) メッシュが参照した近傍の境界。近傍が変化したときに作り直しが必要かの判定に使う
+    // 最初にメッシュを作るときに確保し、スロットを使い回す間は再利用する (メッシュを作らないスロットには持たせない)
+    std::unique_ptr<NeighborBorderSignatures> meshNeighborSignatures;
+    bool hasMeshNeighborSignatures = false;
+    // 実行中のジョブのキャンセル用トークン (ジョブの投入時に作る。Generating / Meshing の間のみ有効)
+    CancellationToken jobCancellation;
+    size_t activeIndex = 0; // m_activeSlots 内の位置
+    // m_chunkCuller / m_culledSlots 内の位置 (描画データを持つ間のみ有効)
+    static constexpr size_t NOT_CULLED = static_cast<size_t>(-1);
+    size_t cullIndex = NOT_CULLED;
+};
+
+// NeighborChunkProvider と、ロード済みチャンクの変更通知 (ChunkChangeListener) を実装
+class ChunkManager : public NeighborChunkProvider, public ChunkChangeListener
 {
 public:
     ChunkManager(int chunkSize, int renderDistanceXZ, unsigned int noiseSeed, float noiseScale,
                  int worldMaxHeight, int groundLevel, int octaves, float lacunarity, float persistence);
     ~ChunkManager();
 
-    void update(const glm::vec3 &playerPosition);
+    // viewFrustum はジョブの優先度付けに使う (視錐台内のチャンクを優先する)
+    // lastFrameWorkSeconds は直前のフレームで CPU が作業していた時間 (垂直同期の待ちを含まない) で、
+    // メッシュの転送などに使うフレームあたりの時間予算の調整に使う
+    void update(const glm::vec3 &playerPosition, const Frustum &viewFrustum, float lastFrameWorkSeconds);
     bool hasChunk(const glm::ivec3 &chunkCoord) const;
-    std::shared_ptr<Chunk> getChunk(const glm::ivec3 &chunkCoord) override; // override を追加
-    const std::unordered_map<glm::ivec3, ChunkRenderData, Vec3iHash> &getAllRenderData() const
+    std::shared_ptr<const Chunk> getChunk(const glm::ivec3 &chunkCoord) override; // override を追加
+    void onChunkDirty(Chunk &chunk) override;
+    // ロード済みのチャンクを edit(Chunk &) で編集する (ロードされていなければ何もせず false を返す)
+    // メッシュ生成ジョブが読んでいる可能性があるので、チャンクを複製して編集し、スロットのチャンクを差し替える
+    template <typename Func>
+    bool editChunk(const glm::ivec3 &chunkCoord, Func &&edit)
+    {
+        std::shared_ptr<Chunk> chunk = cloneChunkForEdit(chunkCoord);
+        if (!chunk)
+        {
+            return false;
+        }
+        edit(*chunk); // 変更は onChunkDirty で通知される
+        return true;
+    }
+    void setMeshingOptions(const MeshingOptions &options) { m_chunkProcessor->setMeshingOptions(options); }
+    // 描画データを持つ全チャンクについて func(chunkCoord, renderData) を呼ぶ
+    template <typename Func>
+    void forEachRenderData(Func &&func) const
     {
-        return m_chunkRenderData;
+        for (const ChunkSlot *slot : m_activeSlots)
+        {
+            if (slot->renderData.hasMesh())
+            {
+                func(slot->coord, slot->renderData);
+            }
+        }
+    }
+    // 描画データを持つチャンクのうち、メッシュの AABB が視錐台と交差するものについて func(chunkCoord, renderData) を呼ぶ
+    // 判定は ChunkCuller でまとめて行う (チャンクが多い場合はワーカーとも分担する)
+    template <typename Func>
+    void forEachVisibleRenderData(const Frustum &viewFrustum, Func &&func)
+    {
+        m_chunkCuller.cull(viewFrustum, m_visibleChunkIndices, m_threadPool.get());
+        for (std::uint32_t index : m_visibleChunkIndices)
+        {
+            const ChunkSlot *slot = m_culledSlots[index];
+            func(slot->coord, slot->renderData);
+        }
     }
 
 private:
@@ -42,23 +151,96 @@ private:
 
     // TerrainGenerator は ChunkProcessor に移動
     std::unique_ptr<ChunkProcessor> m_chunkProcessor; // ChunkProcessor のインスタンスを持つ
+    // チャンク生成・メッシュ生成のジョブを実行するワーカースレッド (ジョブごとにスレッドを作らない)
+    std::unique_ptr<ThreadPool> m_threadPool;
 
-    std::unordered_map<glm::ivec3, std::shared_ptr<Chunk>, Vec3iHash> m_chunks;
-    std::unordered_map<glm::ivec3, ChunkRenderData, Vec3iHash> m_chunkRenderData;
+    // ロード範囲の直径 (2 * m_renderDistance + 1) を一辺とするリングバッファ
+    // 範囲内のチャンク座標は必ず別のスロットに対応する (範囲外になったチャンクは先にアンロードする)
+    ToroidalGrid<ChunkSlot> m_chunkGrid;
+    // 使用中 (Empty 以外) のスロットの一覧 (アンロード判定と描画で走査する)
+    std::vector<ChunkSlot *> m_activeSlots;
+    // メッシュが古くなった可能性があり、状態を確認するチャンク
+    // 変化があったとき (チャンクの編集は Chunk::setDirty からの通知) だけ登録するので、毎フレーム全チャンクを走査しなくてよい
+    std::vector<glm::ivec3> m_dirtyChunks;
+    // 描画データを持つスロットと、そのメッシュのワールド座標での AABB (同じ番号で対応する)
+    ChunkCuller m_chunkCuller;
+    std::vector<ChunkSlot *> m_culledSlots;
+    std::vector<std::uint32_t> m_visibleChunkIndices; // forEachVisibleRenderData の作業用
 
     glm::ivec3 m_lastPlayerChunkCoord;
 
-    // 非同期チャンク生成とメッシュ生成を管理するためのマップ
-    std::unordered_map<glm::ivec3, std::future<std::shared_ptr<Chunk>>, Vec3iHash> m_pendingChunkGenerations;
-    std::unordered_map<glm::ivec3, std::future<ChunkMeshData>, Vec3iHash> m_pendingMeshGenerations;
+    // ロード範囲の球に含まれるオフセット (近い順)
+    std::vector<glm::ivec3> m_sphereOffsets;
+    // 中心が delta (各成分 -1〜1) だけ動いたときに新しく範囲に入るオフセット
+    // インデックスは chunkNeighborhoodIndex(delta)
+    std::array<std::vector<glm::ivec3>, 27> m_enteringShells;
 
-    // ヘルパーメソッド (変更なし)
+    // 実行待ちのジョブ (優先度順にワーカーへ投入される)
+    std::unordered_set<glm::ivec3, Vec3iHash> m_queuedChunkGenerations;
+    std::unordered_set<glm::ivec3, Vec3iHash> m_queuedMeshGenerations;
+    // 実行待ちのジョブの優先度順のヒープ (priority が小さいものが先頭)
+    // 上の集合が実際の待ち状態で、集合から外れたジョブの要素は取り出したときに読み飛ばす
+    // 優先度は追加時に求め、中心のチャンクが変わるか視線の向きが大きく変わったときだけまとめて求め直す
+    struct QueuedJob
+    {
+        float priority;
+        glm::ivec3 chunkCoord;
+        bool isMeshJob;
+
+        // ヒープ用の比較 (priority が小さいジョブを先頭にする)
+        static bool isLowerPriority(const QueuedJob &a, const QueuedJob &b) { return a.priority > b.priority; }
+    };
+    std::vector<QueuedJob> m_jobQueue;
+    glm::ivec3 m_priorityCenter; // 優先度を求めたときの中心のチャンク
+    glm::vec3 m_priorityForward; // 優先度を求めたときの視線方向
+    Frustum m_priorityFrustum;
+
+    // ワーカーへ投入し、まだ完了キューから受け取っていないジョブの数 (キャンセル済みも含む)
+    size_t m_jobsInFlight;
+    // ワーカーが完了したジョブの結果を送るキュー (メインスレッドが毎フレーム溜まった分だけ受け取る)
+    MpscQueue<CompletedChunkGeneration> m_completedChunkGenerations;
+    MpscQueue<CompletedMeshGeneration> m_completedMeshGenerations;
+    // 受け取ったが、まだ描画データを作っていないメッシュ (受け取った順)
+    std::deque<CompletedMeshGeneration> m_meshesToUpload;
+    // 置き換え・アンロードで不要になり、削除を後回しにしている描画データ
+    // (共有頂点バッファの領域を、直前のフレームの描画がまだ参照しているうちに上書きしないためでもある)
+    std::vector<ChunkRenderData> m_renderDataToRelease;
+
+    // メッシュの転送と描画データの削除に使う、1フレームあたりの時間予算
+    FrameBudget m_gpuWorkBudget;
+    WorkCostEstimate m_uploadCost;  // 頂点1つあたり
+    WorkCostEstimate m_releaseCost; // 描画データ1つあたり
+    WorkCostEstimate m_defragmentCost; // 共有頂点バッファ内での移動1バイトあたり
+
+    // ヘルパーメソッド
     glm::ivec3 getChunkCoordFromWorldPos(const glm::vec3 &worldPos) const;
+    ChunkSlot *findSlot(const glm::ivec3 &chunkCoord);
+    const ChunkSlot *findSlot(const glm::ivec3 &chunkCoord) const;
+    ChunkSlot &claimSlot(const glm::ivec3 &chunkCoord);
+    void buildOffsetTables();
+    void updateLoadedArea(const glm::ivec3 &previousCenter, const glm::ivec3 &centerChunkCoord);
     void loadChunksInArea(const glm::ivec3 &centerChunkCoord);
     void unloadDistantChunks(const glm::ivec3 &centerChunkCoord);
-
-    // OpenGLリソースの更新はメインスレッドで行うためのヘルパー (変更なし)
-    void updateChunkRenderData(const glm::ivec3 &chunkCoord, const ChunkMeshData &meshData);
+    void requestChunk(const glm::ivec3 &chunkCoord);
+    void unloadChunk(const glm::ivec3 &chunkCoord);
+    void markChunkDirty(ChunkSlot &slot);
+    std::shared_ptr<Chunk> cloneChunkForEdit(const glm::ivec3 &chunkCoord);
+    void queueDirtyCheck(ChunkSlot &slot);
+    void markNeighborsDirtyIfBorderChanged(const glm::ivec3 &chunkCoord);
+    void processDirtyChunks(const glm::ivec3 &centerChunkCoord);
+    void onChunkGenerated(ChunkSlot &slot, std::shared_ptr<Chunk> chunk);
+    void onMeshGenerated(ChunkSlot &slot, const ChunkMeshData &meshData);
+    void processGpuWork(float lastFrameWorkSeconds);
+    void releaseRenderData(ChunkSlot &slot);
+    void addToCuller(ChunkSlot &slot);
+    void removeFromCuller(ChunkSlot &slot);
+    bool needsMeshGeneration(const glm::ivec3 &chunkCoord, const Chunk &chunk);
+    bool isWithinRenderDistance(const glm::ivec3 &chunkCoord, const glm::ivec3 &centerChunkCoord) const;
+    bool areNeighborsSettled(const glm::ivec3 &chunkCoord, const glm::ivec3 &centerChunkCoord) const;
+    void queueJob(const glm::ivec3 &chunkCoord, bool isMeshJob);
+    void updateJobPriorities(const glm::ivec3 &centerChunkCoord, const Frustum &viewFrustum);
+    void dispatchQueuedJobs();
+    float getJobPriority(const glm::ivec3 &chunkCoord) const;
 };
 
 #endif // CHUNK_MANAGER_HPP
\ No newline at end of file
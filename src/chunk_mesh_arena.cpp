@@ -0,0 +1,256 @@
+#include "chunk_mesh_arena.hpp"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+
+ChunkMeshArena::Handle ChunkMeshArena::allocate(const std::vector<Vertex> &vertices)
+{
+    GLsizei vertexCount = static_cast<GLsizei>(vertices.size());
+
+    int page = -1;
+    GLint firstVertex = 0;
+    for (int i = 0; i < static_cast<int>(m_pages.size()); ++i)
+    {
+        if (tryAllocateInPage(i, vertexCount, firstVertex))
+        {
+            page = i;
+            break;
+        }
+    }
+    if (page < 0)
+    {
+        page = createPage(std::max(PAGE_VERTEX_CAPACITY, vertexCount));
+        tryAllocateInPage(page, vertexCount, firstVertex);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, m_pages[page].buffer);
+    glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(firstVertex) * sizeof(Vertex),
+                    static_cast<GLsizeiptr>(vertexCount) * sizeof(Vertex), vertices.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    Handle handle;
+    if (!m_freeHandles.empty())
+    {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else
+    {
+        handle = static_cast<Handle>(m_entries.size());
+        m_entries.emplace_back();
+    }
+    Entry &entry = m_entries[handle];
+    entry.range = {page, firstVertex, vertexCount};
+    entry.inUse = true;
+    m_pages[page].allocations[firstVertex] = handle;
+    return handle;
+}
+
+void ChunkMeshArena::free(Handle handle)
+{
+    if (handle >= m_entries.size())
+    {
+        return; // release() で既に全て解放されている
+    }
+    Entry &entry = m_entries[handle];
+    if (!entry.inUse)
+    {
+        return;
+    }
+    Page &page = m_pages[entry.range.page];
+    page.allocations.erase(entry.range.firstVertex);
+    page.usedVertices -= entry.range.vertexCount;
+    addFreeBlock(page, entry.range.firstVertex, entry.range.vertexCount);
+
+    // 最初のページ以外は、空になったらバッファごと返す (大きなメッシュ用の専用ページなど)
+    if (page.usedVertices == 0 && entry.range.page != 0)
+    {
+        releasePage(page);
+    }
+
+    entry.inUse = false;
+    entry.range = Range();
+    m_freeHandles.push_back(handle);
+}
+
+GLuint ChunkMeshArena::getVertexArray(int page, GLenum indexType, GLuint indexBuffer, GLuint originBuffer)
+{
+    Page &target = m_pages[page];
+    GLuint &vertexArray = (indexType == GL_UNSIGNED_SHORT) ? target.vertexArray16 : target.vertexArray32;
+    if (vertexArray != 0)
+    {
+        return vertexArray;
+    }
+
+    glGenVertexArrays(1, &vertexArray);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, target.buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    // パック済み頂点 (location = 0)。2つの uint32 を整数のままシェーダーへ渡す (デコードは頂点シェーダー側)
+    // 各メッシュの開始位置は描画時の baseVertex で指定するので、属性のオフセットは常に 0
+    glVertexAttribIPointer(0, 2, GL_UNSIGNED_INT, sizeof(Vertex), (void *)0);
+    glEnableVertexAttribArray(0);
+    if (originBuffer != 0)
+    {
+        // チャンク原点 (location = 1)。描画コマンドの baseInstance で何番目の原点を使うかを選ぶ
+        glBindBuffer(GL_ARRAY_BUFFER, originBuffer);
+        glVertexAttribIPointer(1, 3, GL_INT, sizeof(GLint) * 3, (void *)0);
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(1);
+    }
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    return vertexArray;
+}
+
+size_t ChunkMeshArena::defragmentStep(size_t maxBytes)
+{
+    for (Page &page : m_pages)
+    {
+        if (page.buffer == 0)
+        {
+            continue;
+        }
+        // 先頭に近い隙間から順に、それより後ろにあって隙間に収まるメッシュを探す
+        // (移動先は移動元より前で、かつ重ならない)
+        int gapsChecked = 0;
+        for (auto gap = page.freeBlocks.begin(); gap != page.freeBlocks.end() && gapsChecked < MAX_DEFRAGMENT_GAPS;
+             ++gap, ++gapsChecked)
+        {
+            GLint gapStart = gap->first;
+            GLsizei gapSize = gap->second;
+            for (auto it = page.allocations.upper_bound(gapStart); it != page.allocations.end(); ++it)
+            {
+                Entry &entry = m_entries[it->second];
+                size_t bytes = static_cast<size_t>(entry.range.vertexCount) * sizeof(Vertex);
+                if (entry.range.vertexCount > gapSize || bytes > maxBytes)
+                {
+                    continue;
+                }
+
+                glBindBuffer(GL_COPY_READ_BUFFER, page.buffer);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, page.buffer);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                                    static_cast<GLintptr>(entry.range.firstVertex) * sizeof(Vertex),
+                                    static_cast<GLintptr>(gapStart) * sizeof(Vertex), static_cast<GLsizeiptr>(bytes));
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+                // 隙間の先頭を割り当て、元の領域を空ける (gap のイテレーターはここで無効になる)
+                Handle handle = it->second;
+                GLint oldFirstVertex = entry.range.firstVertex;
+                page.allocations.erase(it);
+                page.freeBlocks.erase(gap);
+                if (gapSize > entry.range.vertexCount)
+                {
+                    page.freeBlocks[gapStart + entry.range.vertexCount] = gapSize - entry.range.vertexCount;
+                }
+                addFreeBlock(page, oldFirstVertex, entry.range.vertexCount);
+                entry.range.firstVertex = gapStart;
+                page.allocations[gapStart] = handle;
+                return bytes;
+            }
+        }
+    }
+    return 0;
+}
+
+void ChunkMeshArena::release()
+{
+    for (Page &page : m_pages)
+    {
+        releasePage(page);
+    }
+    m_pages.clear();
+    m_entries.clear();
+    m_freeHandles.clear();
+}
+
+bool ChunkMeshArena::tryAllocateInPage(int page, GLsizei vertexCount, GLint &firstVertex)
+{
+    Page &target = m_pages[page];
+    if (target.buffer == 0 || target.capacity - target.usedVertices < vertexCount)
+    {
+        return false;
+    }
+    for (auto it = target.freeBlocks.begin(); it != target.freeBlocks.end(); ++it)
+    {
+        if (it->second < vertexCount)
+        {
+            continue;
+        }
+        firstVertex = it->first;
+        GLsizei remaining = it->second - vertexCount;
+        target.freeBlocks.erase(it);
+        if (remaining > 0)
+        {
+            target.freeBlocks[firstVertex + vertexCount] = remaining;
+        }
+        target.usedVertices += vertexCount;
+        return true;
+    }
+    return false; // 空きの合計は足りるが、断片化していて収まらない
+}
+
+int ChunkMeshArena::createPage(GLsizei capacity)
+{
+    // 未使用のページがあれば再利用する (インデックスは他のページと共有しない)
+    int index = -1;
+    for (int i = 0; i < static_cast<int>(m_pages.size()); ++i)
+    {
+        if (m_pages[i].buffer == 0)
+        {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0)
+    {
+        index = static_cast<int>(m_pages.size());
+        m_pages.emplace_back();
+    }
+
+    Page &page = m_pages[index];
+    glGenBuffers(1, &page.buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, page.buffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(capacity) * sizeof(Vertex), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    page.capacity = capacity;
+    page.usedVertices = 0;
+    page.freeBlocks.clear();
+    page.freeBlocks[0] = capacity;
+    page.allocations.clear();
+
+    std::cout << "ChunkMeshArena: created page " << index << " (" << capacity << " vertices)." << std::endl;
+    return index;
+}
+
+void ChunkMeshArena::releasePage(Page &page)
+{
+    if (page.vertexArray16 != 0) glDeleteVertexArrays(1, &page.vertexArray16);
+    if (page.vertexArray32 != 0) glDeleteVertexArrays(1, &page.vertexArray32);
+    if (page.buffer != 0) glDeleteBuffers(1, &page.buffer);
+    page = Page();
+}
+
+// 空き領域を追加し、前後の空き領域と結合する
+void ChunkMeshArena::addFreeBlock(Page &page, GLint firstVertex, GLsizei vertexCount)
+{
+    auto next = page.freeBlocks.lower_bound(firstVertex);
+    if (next != page.freeBlocks.end() && firstVertex + vertexCount == next->first)
+    {
+        vertexCount += next->second;
+        next = page.freeBlocks.erase(next);
+    }
+    if (next != page.freeBlocks.begin())
+    {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == firstVertex)
+        {
+            previous->second += vertexCount;
+            return;
+        }
+    }
+    page.freeBlocks[firstVertex] = vertexCount;
+}
@@ -0,0 +1,88 @@
+#ifndef CHUNK_MESH_ARENA_HPP
+#define CHUNK_MESH_ARENA_HPP
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "mesh_types.hpp"
+
+// 全チャンクのメッシュの頂点を、少数の大きな頂点バッファ (ページ) に詰めて格納する
+// ページ内の領域は空き領域リスト (先頭から最初に収まる領域) で割り当てるので、
+// メッシュを作り直してもバッファオブジェクトの生成・削除は起こらない。
+// 同じページのメッシュは1つの VAO を共有し、描画時は baseVertex で自分の範囲を指定する。
+// 解放で空いた隙間は defragmentStep で後ろのメッシュを前に詰めて解消する。
+// 移動でメッシュの位置は変わるので、利用側はハンドルを保持し、描画のたびに getRange で位置を引く。
+class ChunkMeshArena
+{
+public:
+    using Handle = std::uint32_t;
+    static constexpr Handle INVALID_HANDLE = 0xFFFFFFFFu;
+
+    struct Range
+    {
+        int page = -1;
+        GLint firstVertex = 0;
+        GLsizei vertexCount = 0;
+    };
+
+    ChunkMeshArena() = default;
+    ChunkMeshArena(const ChunkMeshArena &) = delete;
+    ChunkMeshArena &operator=(const ChunkMeshArena &) = delete;
+
+    // 頂点を転送して領域を割り当てる (空の頂点列は渡さないこと)
+    Handle allocate(const std::vector<Vertex> &vertices);
+    // 領域を空き領域に戻す (GL の呼び出しは行わない。ページが空になった場合のみバッファを削除する)
+    // release() の後に呼ばれた場合 (release より長く残った ChunkRenderData の破棄など) は何もしない
+    void free(Handle handle);
+    const Range &getRange(Handle handle) const { return m_entries[handle].range; }
+
+    // page の頂点バッファを参照する VAO (インデックスの型ごとに1つ、初回に作成する)
+    // indexBuffer は indexType の共有インデックスバッファ
+    // originBuffer が 0 でなければ、チャンク原点 (ivec3) のインスタンス属性 (location = 1) として関連付ける
+    // 0 の場合は属性配列を有効にしないので、原点は glVertexAttribI3i で描画ごとに指定する
+    GLuint getVertexArray(int page, GLenum indexType, GLuint indexBuffer, GLuint originBuffer);
+
+    // 隙間より後ろにあるメッシュを1つ、隙間へ移動する (glCopyBufferSubData による GPU 内のコピー)
+    // 移動は maxBytes 以下のメッシュに限る。移動したバイト数を返し、詰められるものがなければ 0 を返す
+    size_t defragmentStep(size_t maxBytes);
+
+    // 全ての GL オブジェクトを削除する (OpenGL コンテキストを破棄する前に呼ぶこと)
+    // それまでに割り当てたハンドルは全て無効になる
+    void release();
+
+private:
+    // 通常のページの頂点数 (8MB)。これより大きなメッシュはそのサイズの専用ページに置く
+    static constexpr GLsizei PAGE_VERTEX_CAPACITY = 1 << 20;
+    // defragmentStep で移動先として調べる隙間の数 (先頭から)
+    static constexpr int MAX_DEFRAGMENT_GAPS = 8;
+
+    struct Page
+    {
+        GLuint buffer = 0; // 0 なら未使用のページ
+        GLsizei capacity = 0;
+        GLsizei usedVertices = 0;
+        GLuint vertexArray16 = 0; // GL_UNSIGNED_SHORT のインデックスバッファを関連付けた VAO
+        GLuint vertexArray32 = 0; // GL_UNSIGNED_INT のインデックスバッファを関連付けた VAO
+        std::map<GLint, GLsizei> freeBlocks;  // 空き領域 (先頭の頂点 → 頂点数)。隣接する領域は常に結合されている
+        std::map<GLint, Handle> allocations;  // 割り当て済みの領域 (先頭の頂点 → ハンドル)
+    };
+
+    struct Entry
+    {
+        Range range;
+        bool inUse = false;
+    };
+
+    std::vector<Page> m_pages;
+    std::vector<Entry> m_entries;
+    std::vector<Handle> m_freeHandles;
+
+    bool tryAllocateInPage(int page, GLsizei vertexCount, GLint &firstVertex);
+    int createPage(GLsizei capacity);
+    void releasePage(Page &page);
+    void addFreeBlock(Page &page, GLint firstVertex, GLsizei vertexCount);
+};
+
+#endif // CHUNK_MESH_ARENA_HPP
@@ -2,70 +2,318 @@
 #include <glm/glm.hpp>
 #include <array>
 #include <vector>
+#include <algorithm>
 #include <iostream>
-#include <random>
-
-ChunkMeshData ChunkMeshGenerator::generateMesh(const Chunk &chunk,
-                                               const Chunk *neighbor_neg_x,
-                                               const Chunk *neighbor_pos_x,
-                                               const Chunk *neighbor_neg_y,
-                                               const Chunk *neighbor_pos_y,
-                                               const Chunk *neighbor_neg_z,
-                                               const Chunk *neighbor_pos_z)
+#include "chunk/bit_utils.hpp"
+
+ChunkMeshData ChunkMeshGenerator::generateMesh(const Chunk &chunk, const ChunkNeighborhood &neighbors,
+                                               const MeshingOptions &options)
 {
     ChunkMeshData meshData;
     int chunkSize = chunk.getSize();
-    const std::vector<bool> &voxels = chunk.getVoxels();
 
-    VoxelAccessor voxelAccessor(chunk,
-                                neighbor_neg_x, neighbor_pos_x,
-                                neighbor_neg_y, neighbor_pos_y,
-                                neighbor_neg_z, neighbor_pos_z);
+    // 全て空気のチャンクには面が存在しない
+    if (chunk.isUniformAir())
+    {
+        return meshData;
+    }
+
+    // チャンクと近傍のボクセルをハロー付きのスナップショットに一度だけコピーする
+    VoxelAccessor voxelAccessor(chunk, neighbors);
 
     FaceBaker faceBaker(voxelAccessor, chunkSize);
 
-    glm::ivec3 chunkCoord = chunk.getCoord();
+    // 1. 列ごとに 6 方向の可視面マスクをシフトとマスクだけで求める
+    // パディング付きの列ではビット y+1 がボクセル y に対応する
+    const Chunk::Column interiorMask = chunk.getFullColumnMask() << 1;
+    const size_t columnCount = static_cast<size_t>(chunkSize) * chunkSize;
+    std::vector<Chunk::Column> faceMasks(columnCount * 6);
+    size_t faceCount = 0;
+
+    for (int z = 0; z < chunkSize; ++z)
+    {
+        for (int x = 0; x < chunkSize; ++x)
+        {
+            Chunk::Column column = voxelAccessor.getPaddedColumn(x, z);
+            Chunk::Column solid = column & interiorMask;
+            Chunk::Column *masks = &faceMasks[(x + z * chunkSize) * 6];
+            if (solid == 0)
+            {
+                std::fill(masks, masks + 6, Chunk::Column(0));
+                continue;
+            }
+
+            // インデックスは neighborOffsets / faceNormals の面番号と一致させる
+            masks[0] = solid & ~voxelAccessor.getPaddedColumn(x, z - 1); // Z-
+            masks[1] = solid & ~voxelAccessor.getPaddedColumn(x, z + 1); // Z+
+            masks[2] = solid & ~voxelAccessor.getPaddedColumn(x - 1, z); // X-
+            masks[3] = solid & ~voxelAccessor.getPaddedColumn(x + 1, z); // X+
+            masks[4] = solid & ~(column << 1);                           // Y- (1つ下のビットが空気)
+            masks[5] = solid & ~(column >> 1);                           // Y+ (1つ上のビットが空気)
 
-    std::seed_seq seed_seq{
-        static_cast<std::uint32_t>(chunkCoord.x),
-        static_cast<std::uint32_t>(chunkCoord.y),
-        static_cast<std::uint32_t>(chunkCoord.z)};
-    std::mt19937 rng(seed_seq);
+            for (int i = 0; i < 6; ++i)
+            {
+                faceCount += bits::popcount(masks[i]);
+            }
+        }
+    }
 
-    std::uniform_int_distribution<int> rotation_dist(0, 3);
-    std::uniform_int_distribution<int> flip_dist(0, 1);
+    const glm::ivec3 chunkOrigin = chunk.getCoord() * chunkSize;
+    if (options.mode == MeshingMode::Greedy)
+    {
+        emitGreedyQuads(meshData, chunk, faceBaker, faceMasks, chunkSize, chunkOrigin, options.randomTextureVariants);
+        computeBounds(meshData);
+        return meshData;
+    }
 
-    meshData.vertices.reserve(chunkSize * chunkSize * chunkSize * 4 * 6);
-    meshData.indices.reserve(chunkSize * chunkSize * chunkSize * 6 * 6);
+    meshData.vertices.reserve(faceCount * 4);
 
-    for (int z = 0; z < chunkSize; ++z)
+    // 2. 立っているビットについてのみ面を生成する
+    // 描画時に向きごとに描画範囲を選べるよう、面の向きごとにまとめて出力する
+    for (int i = 0; i < 6; ++i)
     {
-        for (int y = 0; y < chunkSize; ++y)
+        meshData.faceVertexOffsets[i] = static_cast<std::uint32_t>(meshData.vertices.size());
+        for (int z = 0; z < chunkSize; ++z)
         {
             for (int x = 0; x < chunkSize; ++x)
             {
-                // 現在のボクセルがソリッドかどうかはVoxelAccessor経由で確認
-                // getVoxelValue は VoxelAccessor に移動し、isSolid がその機能を含むようになりました
-                if (voxelAccessor.isSolid(x, y, z)) // チャンク内のボクセルがソリッド
+                Chunk::Column mask = faceMasks[(x + z * chunkSize) * 6 + i];
+                while (mask != 0)
+                {
+                    int y = bits::countTrailingZeros(mask) - 1;
+                    mask &= mask - 1;
+
+                    int rotationAmount;
+                    bool flipHorizontal;
+                    getTextureVariant(chunkOrigin + glm::ivec3(x, y, z), options.randomTextureVariants,
+                                      rotationAmount, flipHorizontal);
+                    int textureLayer = getBlockTextureLayer(chunk.getSolidBlock(x, y, z), i);
+                    faceBaker.bakeFace(meshData, x, y, z, i, textureLayer, rotationAmount, flipHorizontal);
+                }
+            }
+        }
+    }
+    meshData.faceVertexOffsets[6] = static_cast<std::uint32_t>(meshData.vertices.size());
+    computeBounds(meshData);
+    return meshData;
+}
+
+// 面の向きごとに、各層 (法線方向の座標) の可視面を 2 次元の格子上で貪欲に結合する
+// 出力は面の向きごとに連続する (faceVertexOffsets を設定する)
+// 結合できるのは 4 頂点の AO とテクスチャのレイヤー (ブロックの種類と面の向きで決まる) が全て一致する面同士のみ。
+// さらに AO が変化する方向には結合しない (AO が一定の方向に伸ばすだけなら、
+// 補間されるグラデーションは面ごとに生成した場合と完全に一致する)。
+// テクスチャの回転・反転 (randomTextureVariants が有効な場合) も一致する面同士のみ結合する
+// (長方形内の各タイルは同じ向きで繰り返されるので、面ごとに生成した場合と見た目が一致する)。
+void ChunkMeshGenerator::emitGreedyQuads(ChunkMeshData &meshData, const Chunk &chunk, FaceBaker &faceBaker,
+                                         const std::vector<Chunk::Column> &faceMasks,
+                                         int chunkSize, const glm::ivec3 &chunkOrigin, bool randomTextureVariants)
+{
+    // 結合キー: 0 は面なし。それ以外は 1 + 下記のビット列
+    // bit 0-1: 回転量, bit 2: 反転, bit 3-10: 4頂点の AO (各2ビット), bit 11: u 方向に結合可, bit 12: v 方向に結合可,
+    // bit 13-20: テクスチャのレイヤー
+    constexpr std::uint32_t MERGE_U = 1u << 11;
+    constexpr std::uint32_t MERGE_V = 1u << 12;
+    constexpr int TEXTURE_LAYER_SHIFT = 13;
+    std::vector<std::uint32_t> keys(static_cast<size_t>(chunkSize) * chunkSize);
+
+    for (int faceIndex = 0; faceIndex < 6; ++faceIndex)
+    {
+        meshData.faceVertexOffsets[faceIndex] = static_cast<std::uint32_t>(meshData.vertices.size());
+
+        // 法線の軸と、面内の 2 軸 (u, v)
+        const int normalAxis = (faceIndex < 2) ? 2 : (faceIndex < 4 ? 0 : 1);
+        const int uAxis = (normalAxis == 0) ? 1 : 0;
+        const int vAxis = (normalAxis == 2) ? 1 : 2;
+
+        // 各頂点が面内のどの角 (u, v それぞれ 0 か 1) に位置するか
+        std::array<int, 4> cornerU, cornerV;
+        for (int k = 0; k < 4; ++k)
+        {
+            const glm::ivec3 &corner = baseCubeVertices[cubeFaceBaseIndices[faceIndex][k]];
+            cornerU[k] = corner[uAxis];
+            cornerV[k] = corner[vAxis];
+        }
+
+        for (int layer = 0; layer < chunkSize; ++layer)
+        {
+            // 1. この層の可視面のキーを格子に書き込む
+            bool hasFace = false;
+            for (int v = 0; v < chunkSize; ++v)
+            {
+                for (int u = 0; u < chunkSize; ++u)
+                {
+                    glm::ivec3 pos;
+                    pos[normalAxis] = layer;
+                    pos[uAxis] = u;
+                    pos[vAxis] = v;
+
+                    std::uint32_t &key = keys[u + v * chunkSize];
+                    key = 0;
+                    Chunk::Column mask = faceMasks[(pos.x + pos.z * chunkSize) * 6 + faceIndex];
+                    if (((mask >> (pos.y + 1)) & 1) == 0)
+                    {
+                        continue;
+                    }
+
+                    std::array<int, 4> ao = faceBaker.computeFaceAO(pos.x, pos.y, pos.z, faceIndex);
+                    int rotationAmount;
+                    bool flipHorizontal;
+                    getTextureVariant(chunkOrigin + pos, randomTextureVariants, rotationAmount, flipHorizontal);
+
+                    int textureLayer = getBlockTextureLayer(chunk.getSolidBlock(pos.x, pos.y, pos.z), faceIndex);
+
+                    std::uint32_t code = MERGE_U | MERGE_V | static_cast<std::uint32_t>(rotationAmount) |
+                                         (flipHorizontal ? 4u : 0u) |
+                                         (static_cast<std::uint32_t>(textureLayer) << TEXTURE_LAYER_SHIFT);
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        code |= static_cast<std::uint32_t>(ao[k]) << (3 + k * 2);
+                        for (int l = k + 1; l < 4; ++l)
+                        {
+                            if (ao[k] == ao[l])
+                            {
+                                continue;
+                            }
+                            // 同じ v 上の頂点で AO が違えば u 方向に変化している
+                            if (cornerV[k] == cornerV[l])
+                            {
+                                code &= ~MERGE_U;
+                            }
+                            if (cornerU[k] == cornerU[l])
+                            {
+                                code &= ~MERGE_V;
+                            }
+                        }
+                    }
+                    key = code + 1;
+                    hasFace = true;
+                }
+            }
+            if (!hasFace)
+            {
+                continue;
+            }
+
+            // 2. 同じキーの面を u 方向、続いて v 方向に広げて長方形にまとめる
+            for (int v = 0; v < chunkSize; ++v)
+            {
+                for (int u = 0; u < chunkSize;)
                 {
-                    int rotationAmount = rotation_dist(rng);
-                    bool flipHorizontal = (flip_dist(rng) == 1);
+                    std::uint32_t key = keys[u + v * chunkSize];
+                    if (key == 0)
+                    {
+                        ++u;
+                        continue;
+                    }
+                    std::uint32_t code = key - 1;
 
-                    for (int i = 0; i < 6; ++i)
+                    int width = 1;
+                    if (code & MERGE_U)
                     {
-                        glm::ivec3 offset = neighborOffsets[i];
-                        int neighborX = x + offset.x;
-                        int neighborY = y + offset.y;
-                        int neighborZ = z + offset.z;
+                        while (u + width < chunkSize && keys[u + width + v * chunkSize] == key)
+                        {
+                            ++width;
+                        }
+                    }
 
-                        if (!voxelAccessor.isSolid(neighborX, neighborY, neighborZ))
+                    int height = 1;
+                    bool canExtend = (code & MERGE_V) != 0;
+                    while (v + height < chunkSize && canExtend)
+                    {
+                        for (int k = 0; k < width; ++k)
+                        {
+                            if (keys[u + k + (v + height) * chunkSize] != key)
+                            {
+                                canExtend = false;
+                                break;
+                            }
+                        }
+                        if (canExtend)
                         {
-                            faceBaker.bakeFace(meshData, x, y, z, i, rotationAmount, flipHorizontal);
+                            ++height;
                         }
                     }
+
+                    // 使用した面をクリア
+                    for (int dv = 0; dv < height; ++dv)
+                    {
+                        std::fill_n(&keys[u + (v + dv) * chunkSize], width, std::uint32_t(0));
+                    }
+
+                    glm::ivec3 pos;
+                    pos[normalAxis] = layer;
+                    pos[uAxis] = u;
+                    pos[vAxis] = v;
+                    glm::ivec3 extent(1);
+                    extent[uAxis] = width;
+                    extent[vAxis] = height;
+
+                    std::array<int, 4> ao;
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        ao[k] = static_cast<int>((code >> (3 + k * 2)) & 3u);
+                    }
+                    int rotationAmount = static_cast<int>(code & 3u);
+                    bool flipHorizontal = (code & 4u) != 0;
+                    int textureLayer = static_cast<int>((code >> TEXTURE_LAYER_SHIFT) & VERTEX_TEXTURE_LAYER_MASK);
+                    faceBaker.bakeQuad(meshData, pos.x, pos.y, pos.z, faceIndex, extent,
+                                       textureLayer, rotationAmount, flipHorizontal, ao);
+                    u += width;
                 }
             }
         }
     }
-    return meshData;
-}
\ No newline at end of file
+    meshData.faceVertexOffsets[6] = static_cast<std::uint32_t>(meshData.vertices.size());
+}
+
+// ボクセルのワールド座標から、テクスチャの回転量と反転を決定的に求める
+// 面の生成順に依存しないよう、乱数列ではなく座標のハッシュを使う
+void ChunkMeshGenerator::getTextureVariant(const glm::ivec3 &worldPos, bool randomTextureVariants,
+                                           int &rotationAmount, bool &flipHorizontal)
+{
+    if (!randomTextureVariants)
+    {
+        rotationAmount = 0;
+        flipHorizontal = false;
+        return;
+    }
+    std::uint32_t h = static_cast<std::uint32_t>(worldPos.x) * 73856093u ^
+                      static_cast<std::uint32_t>(worldPos.y) * 19349663u ^
+                      static_cast<std::uint32_t>(worldPos.z) * 83492791u;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    rotationAmount = static_cast<int>(h & 3u);
+    flipHorizontal = ((h >> 2) & 1u) != 0;
+}
+
+void ChunkMeshGenerator::computeBounds(ChunkMeshData &meshData)
+{
+    if (meshData.vertices.empty())
+    {
+        meshData.boundsMin = glm::ivec3(0);
+        meshData.boundsMax = glm::ivec3(0);
+        return;
+    }
+
+    // 座標は packVertex で詰めた 7bit ずつの値
+    std::uint32_t minX = VERTEX_COORD_MASK, minY = VERTEX_COORD_MASK, minZ = VERTEX_COORD_MASK;
+    std::uint32_t maxX = 0, maxY = 0, maxZ = 0;
+    for (const Vertex &vertex : meshData.vertices)
+    {
+        std::uint32_t x = vertex.position & VERTEX_COORD_MASK;
+        std::uint32_t y = (vertex.position >> 7) & VERTEX_COORD_MASK;
+        std::uint32_t z = (vertex.position >> 14) & VERTEX_COORD_MASK;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        minZ = std::min(minZ, z);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+        maxZ = std::max(maxZ, z);
+    }
+    meshData.boundsMin = glm::ivec3(minX, minY, minZ);
+    meshData.boundsMax = glm::ivec3(maxX, maxY, maxZ);
+}
@@ -25,17 +25,36 @@ const std::array<glm::ivec3, 6> neighborOffsets = {
     glm::ivec3(0, 1, 0)   // Top face (Y+)
 };
 
+// メッシュの生成方法
+enum class MeshingMode
+{
+    PerFace, // 可視面ごとに 1 枚の四角形を出力する
+    Greedy   // 同一平面上で隣接し、AO とテクスチャの回転・反転が一致する面を大きな四角形に結合する
+};
+
+struct MeshingOptions
+{
+    MeshingMode mode = MeshingMode::PerFace;
+    // ボクセルごとにテクスチャをランダムに回転・反転する
+    // Greedy では回転・反転の異なる面は結合できないため、無効にすると頂点数が大きく減る
+    bool randomTextureVariants = true;
+};
+
 class ChunkMeshGenerator
 {
 public:
-    static ChunkMeshData generateMesh(const Chunk &chunk,
-                                      const Chunk* neighbor_neg_x = nullptr,
-                                      const Chunk* neighbor_pos_x = nullptr,
-                                      const Chunk* neighbor_neg_y = nullptr,
-                                      const Chunk* neighbor_pos_y = nullptr,
-                                      const Chunk* neighbor_neg_z = nullptr,
-                                      const Chunk* neighbor_pos_z = nullptr
-                                     );
+    // neighbors には 26 近傍のチャンクを渡す (中央の要素は使用しない)
+    static ChunkMeshData generateMesh(const Chunk &chunk, const ChunkNeighborhood &neighbors,
+                                      const MeshingOptions &options = MeshingOptions());
+
+private:
+    static void emitGreedyQuads(ChunkMeshData &meshData, const Chunk &chunk, FaceBaker &faceBaker,
+                                const std::vector<Chunk::Column> &faceMasks,
+                                int chunkSize, const glm::ivec3 &chunkOrigin, bool randomTextureVariants);
+    // 生成した頂点から boundsMin / boundsMax を求める
+    static void computeBounds(ChunkMeshData &meshData);
+    static void getTextureVariant(const glm::ivec3 &worldPos, bool randomTextureVariants,
+                                  int &rotationAmount, bool &flipHorizontal);
 };
 
 #endif // CHUNK_MESH_GENERATOR_HPP
\ No newline at end of file
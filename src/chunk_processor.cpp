@@ -1,5 +1,14 @@
 #include "chunk_processor.hpp"
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include "chunk/bit_utils.hpp"
+
+namespace
+{
+    // 地表の草の下にある土の層の厚さ
+    constexpr int DIRT_DEPTH = 3;
+}
 
 ChunkProcessor::ChunkProcessor(int chunkSize, std::unique_ptr<TerrainGenerator> terrainGenerator)
     : m_chunkSize(chunkSize), m_terrainGenerator(std::move(terrainGenerator))
@@ -8,8 +17,15 @@ ChunkProcessor::ChunkProcessor(int chunkSize, std::unique_ptr<TerrainGenerator>
 }
 
 // チャンクのボクセルデータを生成する (非同期で実行される計算処理)
-std::shared_ptr<Chunk> ChunkProcessor::generateChunkData(const glm::ivec3& chunkCoord)
+std::shared_ptr<Chunk> ChunkProcessor::generateChunkData(const glm::ivec3& chunkCoord,
+                                                         const CancellationToken& cancellation)
 {
+    // 実行を待っている間に範囲外になったチャンクは生成しない
+    if (cancellation.isCancelled())
+    {
+        return nullptr;
+    }
+
     std::shared_ptr<Chunk> newChunk = std::make_shared<Chunk>(m_chunkSize, chunkCoord);
     if (!m_terrainGenerator)
     {
@@ -17,60 +33,103 @@ std::shared_ptr<Chunk> ChunkProcessor::generateChunkData(const glm::ivec3& chunk
         return newChunk;
     }
 
-    std::vector<int> heightMap(m_chunkSize * m_chunkSize);
-    for (int x = 0; x < m_chunkSize; ++x)
+    const int chunkBaseY = chunkCoord.y * m_chunkSize;
+    const int groundLevel = m_terrainGenerator->getGroundLevel();
+
+    // 地形の最高点より上、または地面より完全に下のチャンクはノイズを評価せずに一様なチャンクとする
+    // (新しく作られたチャンクは一様な空気なので、空の場合は何もしなくてよい)
+    if (chunkBaseY >= std::max(groundLevel, m_terrainGenerator->getWorldMaxHeight()))
+    {
+        return newChunk;
+    }
+    // (地表は groundLevel 以上にあるので、その下の草・土の層より下なら全て石)
+    if (chunkBaseY + m_chunkSize <= groundLevel - 1 - DIRT_DEPTH)
     {
-        for (int z = 0; z < m_chunkSize; ++z)
+        newChunk->fill(DEFAULT_SOLID_BLOCK);
+        return newChunk;
+    }
+
+    // 地形は高さマップなので、各 (x, z) 列のソリッド部分は下端から連続する。
+    // そのため列ごとにソリッドなボクセル数を求め、1ワードのマスクとして書き込む。
+    // (全列が空または満杯なら setColumns が一様なチャンクにまとめる)
+    // 地表の素材は列ごとの地表の高さから決めるので、高さも残しておく
+    std::vector<Chunk::Column> columns(m_chunkSize * m_chunkSize);
+    std::vector<int> surfaceHeights(m_chunkSize * m_chunkSize);
+    for (int z = 0; z < m_chunkSize; ++z)
+    {
+        // ノイズの評価が処理の大半なので、行ごとにキャンセルを確認する
+        if (cancellation.isCancelled())
+        {
+            return nullptr;
+        }
+        for (int x = 0; x < m_chunkSize; ++x)
         {
             float worldX = (float)x + (float)chunkCoord.x * m_chunkSize;
             float worldZ = (float)z + (float)chunkCoord.z * m_chunkSize;
-            heightMap[x + z * m_chunkSize] = m_terrainGenerator->getTerrainHeight(worldX, worldZ);
+            int terrainHeightAtXZ = m_terrainGenerator->getTerrainHeight(worldX, worldZ);
+
+            // worldY < max(groundLevel, terrainHeight) の範囲がソリッド
+            int solidTop = std::max(groundLevel, terrainHeightAtXZ);
+            int solidCount = std::clamp(solidTop - chunkBaseY, 0, m_chunkSize);
+            columns[x + z * m_chunkSize] = bits::lowMask(solidCount);
+            surfaceHeights[x + z * m_chunkSize] = solidTop;
         }
     }
+    newChunk->setColumns(columns);
 
-    std::vector<bool> tempVoxels(m_chunkSize * m_chunkSize * m_chunkSize);
-
+    // 地表の 1 層を草、その下の DIRT_DEPTH 層を土にする (それより下は既定の石のまま)
+    // 書き換えるのは地表付近のボクセルだけなので、地中深くのチャンクはパレットが石のみのまま
     for (int z = 0; z < m_chunkSize; ++z)
     {
-        for (int y = 0; y < m_chunkSize; ++y)
+        for (int x = 0; x < m_chunkSize; ++x)
         {
-            for (int x = 0; x < m_chunkSize; ++x)
+            int solidTop = surfaceHeights[x + z * m_chunkSize];
+            int beginY = std::max(solidTop - 1 - DIRT_DEPTH, chunkBaseY);
+            int endY = std::min(solidTop, chunkBaseY + m_chunkSize);
+            for (int worldY = beginY; worldY < endY; ++worldY)
             {
-                float worldY = (float)y + (float)chunkCoord.y * m_chunkSize;
-
-                bool isSolid;
-                if (worldY < m_terrainGenerator->getGroundLevel())
-                {
-                    isSolid = true;
-                }
-                else
-                {
-                    int terrainHeightAtXZ = heightMap[x + z * m_chunkSize];
-                    isSolid = (worldY < terrainHeightAtXZ);
-                }
-
-                size_t index = static_cast<size_t>(x + y * m_chunkSize + z * m_chunkSize * m_chunkSize);
-                tempVoxels[index] = isSolid;
+                BlockId block = (worldY == solidTop - 1) ? BLOCK_GRASS : BLOCK_DIRT;
+                newChunk->setBlock(x, worldY - chunkBaseY, z, block);
             }
         }
     }
-    newChunk->setVoxels(tempVoxels);
     return newChunk;
 }
 
-// 隣接チャンク取得のためのヘルパー関数
-const Chunk* ChunkProcessor::getNeighbor(const glm::ivec3& currentChunkCoord, const glm::ivec3& offset,
-                                         NeighborChunkProvider* neighborProvider)
+// 26 近傍のチャンクのスナップショットを作成する
+// AO は辺・角で接するチャンクのボクセルも参照するため、面で接するチャンクだけでは足りない
+ChunkNeighborSnapshot ChunkProcessor::collectNeighbors(const glm::ivec3& chunkCoord,
+                                                       NeighborChunkProvider* neighborProvider)
 {
-    if (!neighborProvider) return nullptr; // プロバイダがない場合はnullptrを返す
-    std::shared_ptr<Chunk> neighborChunk = neighborProvider->getChunk(currentChunkCoord + offset);
-    return neighborChunk.get(); // shared_ptr から生ポインタを取得
+    ChunkNeighborSnapshot snapshot;
+    if (!neighborProvider) return snapshot; // プロバイダがない場合は近傍なし
+    for (int dz = -1; dz <= 1; ++dz)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                if (dx == 0 && dy == 0 && dz == 0)
+                {
+                    continue;
+                }
+                snapshot[chunkNeighborhoodIndex(dx, dy, dz)] =
+                    neighborProvider->getChunk(chunkCoord + glm::ivec3(dx, dy, dz));
+            }
+        }
+    }
+    return snapshot;
 }
 
 // チャンクのメッシュデータを生成する (非同期で実行される計算処理)
-ChunkMeshData ChunkProcessor::generateMeshForChunk(const glm::ivec3& chunkCoord, std::shared_ptr<Chunk> chunk,
-                                                   NeighborChunkProvider* neighborProvider)
+ChunkMeshData ChunkProcessor::generateMeshForChunk(const glm::ivec3& chunkCoord, std::shared_ptr<const Chunk> chunk,
+                                                   const ChunkNeighborSnapshot& neighborSnapshot,
+                                                   const CancellationToken& cancellation)
 {
+    if (cancellation.isCancelled())
+    {
+        return ChunkMeshData();
+    }
     if (!chunk)
     {
         std::cerr << "Error: Attempted to generate mesh data for a null chunk at "
@@ -78,18 +137,13 @@ ChunkMeshData ChunkProcessor::generateMeshForChunk(const glm::ivec3& chunkCoord,
         return ChunkMeshData(); // 空のメッシュデータを返す
     }
 
-    // 隣接チャンクのデータを取得
-    const Chunk *neighbor_neg_x = getNeighbor(chunkCoord, glm::ivec3(-1, 0, 0), neighborProvider);
-    const Chunk *neighbor_pos_x = getNeighbor(chunkCoord, glm::ivec3(1, 0, 0), neighborProvider);
-    const Chunk *neighbor_neg_y = getNeighbor(chunkCoord, glm::ivec3(0, -1, 0), neighborProvider);
-    const Chunk *neighbor_pos_y = getNeighbor(chunkCoord, glm::ivec3(0, 1, 0), neighborProvider);
-    const Chunk *neighbor_neg_z = getNeighbor(chunkCoord, glm::ivec3(0, 0, -1), neighborProvider);
-    const Chunk *neighbor_pos_z = getNeighbor(chunkCoord, glm::ivec3(0, 0, 1), neighborProvider);
+    ChunkNeighborhood neighbors{};
+    for (size_t i = 0; i < neighbors.size(); ++i)
+    {
+        neighbors[i] = neighborSnapshot[i].get();
+    }
 
     // ChunkMeshGenerator を使用してメッシュデータを生成
-    ChunkMeshData meshData = ChunkMeshGenerator::generateMesh(*chunk,
-                                                              neighbor_neg_x, neighbor_pos_x,
-                                                              neighbor_neg_y, neighbor_pos_y,
-                                                              neighbor_neg_z, neighbor_pos_z);
+    ChunkMeshData meshData = ChunkMeshGenerator::generateMesh(*chunk, neighbors, m_meshingOptions);
     return meshData;
-}
\ No newline at end of file
+}
@@ -1,40 +1,54 @@
 #ifndef CHUNK_PROCESSOR_HPP
 #define CHUNK_PROCESSOR_HPP
 
+#include <array>
 #include <memory>
 #include <glm/glm.hpp>
 #include "chunk/chunk.hpp"
 #include "chunk_mesh_generator.hpp"
 #include "terrain_generator.hpp"
+#include "thread/cancellation_token.hpp"
 
 // NeighborChunkProvider インターフェースを定義
 // チャンクプロセッサが隣接チャンクを取得するための抽象インターフェース
+// (ChunkProcessor::collectNeighbors からのみ呼ばれ、ワーカースレッドからは呼ばれない)
 class NeighborChunkProvider {
 public:
     virtual ~NeighborChunkProvider() = default;
-    virtual std::shared_ptr<Chunk> getChunk(const glm::ivec3& chunkCoord) = 0;
+    virtual std::shared_ptr<const Chunk> getChunk(const glm::ivec3& chunkCoord) = 0;
 };
 
+// メッシュ生成ジョブに渡す 26 近傍のチャンク (インデックスは chunkNeighborhoodIndex、中央は未使用)
+// ジョブの投入時にメインスレッドで作成する不変のスナップショットで、ワーカーは ChunkManager の
+// チャンク表を一切参照しない。shared_ptr を保持するので、ジョブの実行中にアンロードされても参照先は解放されない。
+// 編集は複製したチャンクに対して行われる (ChunkManager::editChunk) ため、参照先の内容も変化しない。
+using ChunkNeighborSnapshot = std::array<std::shared_ptr<const Chunk>, 27>;
+
 class ChunkProcessor {
 public:
     ChunkProcessor(int chunkSize, std::unique_ptr<TerrainGenerator> terrainGenerator);
 
     // チャンクのボクセルデータを生成する (非同期で実行される計算処理)
-    std::shared_ptr<Chunk> generateChunkData(const glm::ivec3& chunkCoord);
+    // キャンセルされた場合は nullptr を返す
+    std::shared_ptr<Chunk> generateChunkData(const glm::ivec3& chunkCoord, const CancellationToken& cancellation);
+
+    // メッシュ生成ジョブ用に 26 近傍のスナップショットを作成する (チャンク表を持つスレッドで呼ぶこと)
+    static ChunkNeighborSnapshot collectNeighbors(const glm::ivec3& chunkCoord, NeighborChunkProvider* neighborProvider);
 
     // チャンクのメッシュデータを生成する (非同期で実行される計算処理)
-    // 隣接チャンクのデータを取得するために NeighborChunkProvider を使用
-    ChunkMeshData generateMeshForChunk(const glm::ivec3& chunkCoord, std::shared_ptr<Chunk> chunk,
-                                       NeighborChunkProvider* neighborProvider);
+    // 隣接チャンクは collectNeighbors で作成したスナップショットから参照する
+    // キャンセルされた場合は空のメッシュデータを返す
+    ChunkMeshData generateMeshForChunk(const glm::ivec3& chunkCoord, std::shared_ptr<const Chunk> chunk,
+                                       const ChunkNeighborSnapshot& neighborSnapshot,
+                                       const CancellationToken& cancellation);
+
+    // メッシュ生成方法を設定 (ジョブを開始する前にメインスレッドから設定すること)
+    void setMeshingOptions(const MeshingOptions& options) { m_meshingOptions = options; }
 
 private:
     int m_chunkSize;
     std::unique_ptr<TerrainGenerator> m_terrainGenerator;
-
-    // 隣接チャンク取得のためのヘルパー関数
-    // ChunkProcessor 内部でのみ使用されるため、private に定義
-    const Chunk* getNeighbor(const glm::ivec3& currentChunkCoord, const glm::ivec3& offset,
-                             NeighborChunkProvider* neighborProvider);
+    MeshingOptions m_meshingOptions;
 };
 
 #endif // CHUNK_PROCESSOR_HPP
\ No newline at end of file
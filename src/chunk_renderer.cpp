@@ -1,47 +1,259 @@
 // src/chunk_renderer.cpp
 #include "chunk_renderer.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
+#include <vector>
+
+GLuint ChunkRenderer::s_quadIndexBuffer16 = 0;
+GLuint ChunkRenderer::s_quadIndexBuffer32 = 0;
+size_t ChunkRenderer::s_quadCapacity32 = 0;
+ChunkMeshArena ChunkRenderer::s_meshArena;
+int ChunkRenderer::s_indirectDrawSupported = -1;
+GLuint ChunkRenderer::s_chunkOriginBuffer = 0;
+GLuint ChunkRenderer::s_indirectBuffer = 0;
+std::vector<glm::ivec3> ChunkRenderer::s_chunkOrigins;
+std::vector<ChunkRenderer::PendingDraw> ChunkRenderer::s_pendingDraws;
+std::vector<ChunkRenderer::DrawElementsIndirectCommand> ChunkRenderer::s_indirectCommands;
+std::vector<GLsizei> ChunkRenderer::s_drawCounts;
+std::vector<const void*> ChunkRenderer::s_drawIndexOffsets;
+std::vector<GLint> ChunkRenderer::s_drawBaseVertices;
+
+namespace
+{
+    // quadCount 枚分の四角形インデックス (0,1,2 / 0,2,3 + 4k) を生成する
+    template <typename IndexType>
+    std::vector<IndexType> buildQuadIndices(size_t quadCount)
+    {
+        std::vector<IndexType> indices(quadCount * 6);
+        for (size_t quad = 0; quad < quadCount; ++quad)
+        {
+            IndexType base = static_cast<IndexType>(quad * 4);
+            IndexType *dst = &indices[quad * 6];
+            dst[0] = base + 0;
+            dst[1] = base + 1;
+            dst[2] = base + 2;
+            dst[3] = base + 0;
+            dst[4] = base + 2;
+            dst[5] = base + 3;
+        }
+        return indices;
+    }
+}
+
+ChunkRenderData::~ChunkRenderData() {
+    if (meshHandle != NO_MESH) ChunkRenderer::s_meshArena.free(meshHandle);
+}
+
+ChunkRenderData& ChunkRenderData::operator=(ChunkRenderData&& other) noexcept {
+    if (this != &other) {
+        if (meshHandle != NO_MESH) ChunkRenderer::s_meshArena.free(meshHandle);
+        meshHandle = other.meshHandle;
+        indexCount = other.indexCount;
+        indexType = other.indexType;
+        faceIndexOffsets = other.faceIndexOffsets;
+        boundsMin = other.boundsMin;
+        boundsMax = other.boundsMax;
+        other.meshHandle = NO_MESH;
+        other.indexCount = 0;
+    }
+    return *this;
+}
 
 ChunkRenderData ChunkRenderer::createChunkRenderData(const ChunkMeshData& meshData) {
     ChunkRenderData renderData;
 
-    if (meshData.vertices.empty() || meshData.indices.empty()) {
+    if (meshData.vertices.empty()) {
         return renderData;
     }
 
-    glGenVertexArrays(1, &renderData.VAO);
-    glGenBuffers(1, &renderData.VBO);
-    glGenBuffers(1, &renderData.EBO);
-
-    glBindVertexArray(renderData.VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, renderData.VBO);
-    glBufferData(GL_ARRAY_BUFFER, meshData.vertices.size() * sizeof(Vertex), meshData.vertices.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderData.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, meshData.indices.size() * sizeof(unsigned int), meshData.indices.data(), GL_STATIC_DRAW);
-
-    // 頂点属性ポインタを設定
-    // 位置属性 (location = 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-    // 色属性 (location = 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    // テクスチャ座標属性 (location = 2)
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    // 法線属性 (location = 3)
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(8 * sizeof(float)));
-    glEnableVertexAttribArray(3);
-    // AO属性 (location = 4) <--- 新しく追加
-    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(11 * sizeof(float)));
-    glEnableVertexAttribArray(4);
-
-    glBindVertexArray(0); // VAOのバインドを解除
-    glBindBuffer(GL_ARRAY_BUFFER, 0); // VBOのバインドを解除
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // EBOのバインドを解除
-
-    renderData.indexCount = static_cast<GLsizei>(meshData.indices.size());
+    size_t quadCount = meshData.vertices.size() / 4;
+
+    // 共有インデックスバッファは描画時にページの VAO へ関連付けるので、ここでは容量の確保だけを行う
+    glBindVertexArray(0);
+    getQuadIndexBuffer(quadCount, renderData.indexType);
+
+    renderData.meshHandle = s_meshArena.allocate(meshData.vertices);
+    renderData.indexCount = static_cast<GLsizei>(quadCount * 6);
+    // 頂点4つが1枚の四角形 (インデックス6つ) に対応する
+    for (size_t i = 0; i < renderData.faceIndexOffsets.size(); ++i) {
+        renderData.faceIndexOffsets[i] = static_cast<GLsizei>(meshData.faceVertexOffsets[i] / 4 * 6);
+    }
+    renderData.boundsMin = meshData.boundsMin;
+    renderData.boundsMax = meshData.boundsMax;
     return renderData;
-}
\ No newline at end of file
+}
+
+ChunkRenderer::DrawInfo ChunkRenderer::getDrawInfo(const ChunkRenderData& renderData) {
+    const ChunkMeshArena::Range& range = s_meshArena.getRange(renderData.meshHandle);
+    GLuint indexBuffer = (renderData.indexType == GL_UNSIGNED_SHORT) ? s_quadIndexBuffer16 : s_quadIndexBuffer32;
+    return {s_meshArena.getVertexArray(range.page, renderData.indexType, indexBuffer, s_chunkOriginBuffer),
+            range.firstVertex};
+}
+
+void ChunkRenderer::drawChunks(const std::vector<ChunkDrawItem>& items) {
+    if (s_indirectDrawSupported < 0) {
+        // VAO はページごとに一度だけ作るので、描画経路は最初に決めたものを使い続ける
+        s_indirectDrawSupported = GLAD_GL_VERSION_4_3 ? 1 : 0;
+        if (s_indirectDrawSupported) {
+            glGenBuffers(1, &s_chunkOriginBuffer);
+            glGenBuffers(1, &s_indirectBuffer);
+        }
+        std::cout << "ChunkRenderer: using "
+                  << (s_indirectDrawSupported ? "glMultiDrawElementsIndirect" : "glMultiDrawElementsBaseVertex")
+                  << " for chunk rendering." << std::endl;
+    }
+
+    s_chunkOrigins.clear();
+    s_pendingDraws.clear();
+    for (const ChunkDrawItem& item : items) {
+        const ChunkRenderData& renderData = *item.renderData;
+        if (!renderData.hasMesh() || renderData.indexCount == 0 || (item.visibleFaceMask & Renderer::ALL_FACE_DIRECTIONS) == 0) {
+            continue;
+        }
+
+        // 頂点は共有頂点バッファ内にあり、baseVertex でこのチャンクの先頭を指定する
+        DrawInfo drawInfo = getDrawInfo(renderData);
+        GLuint originIndex = static_cast<GLuint>(s_chunkOrigins.size());
+        s_chunkOrigins.push_back(item.origin);
+        // 見える向きの範囲だけを描画する。連続する向きは1つのコマンドにまとめる
+        for (int face = 0; face < 6;) {
+            if ((item.visibleFaceMask & (1u << face)) == 0) {
+                ++face;
+                continue;
+            }
+            int endFace = face + 1;
+            while (endFace < 6 && (item.visibleFaceMask & (1u << endFace)) != 0) {
+                ++endFace;
+            }
+            GLsizei first = renderData.faceIndexOffsets[face];
+            GLsizei count = renderData.faceIndexOffsets[endFace] - first;
+            if (count > 0) {
+                s_pendingDraws.push_back({drawInfo.vertexArray, renderData.indexType,
+                                          {static_cast<GLuint>(count), 1, static_cast<GLuint>(first),
+                                           drawInfo.baseVertex, originIndex}});
+            }
+            face = endFace;
+        }
+    }
+    if (s_pendingDraws.empty()) {
+        return;
+    }
+
+    // 同じ VAO のコマンドを連続させる (安定ソートなので、1つのチャンクのコマンドは並んだまま)
+    std::stable_sort(s_pendingDraws.begin(), s_pendingDraws.end(),
+                     [](const PendingDraw& a, const PendingDraw& b) { return a.vertexArray < b.vertexArray; });
+
+    if (s_indirectDrawSupported) {
+        drawIndirect();
+    } else {
+        drawBaseVertex();
+    }
+    glBindVertexArray(0);
+}
+
+void ChunkRenderer::drawIndirect() {
+    // 原点とコマンドはフレームごとに丸ごと作り直す (glBufferData で古い内容を捨てる)
+    // 原点バッファの名前は変わらないので、VAO に関連付けた属性はそのまま有効
+    glBindBuffer(GL_ARRAY_BUFFER, s_chunkOriginBuffer);
+    glBufferData(GL_ARRAY_BUFFER, s_chunkOrigins.size() * sizeof(glm::ivec3), s_chunkOrigins.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    s_indirectCommands.clear();
+    for (const PendingDraw& draw : s_pendingDraws) {
+        s_indirectCommands.push_back(draw.command);
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, s_indirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, s_indirectCommands.size() * sizeof(DrawElementsIndirectCommand),
+                 s_indirectCommands.data(), GL_STREAM_DRAW);
+
+    for (size_t begin = 0; begin < s_pendingDraws.size();) {
+        size_t end = begin + 1;
+        while (end < s_pendingDraws.size() && s_pendingDraws[end].vertexArray == s_pendingDraws[begin].vertexArray) {
+            ++end;
+        }
+        glBindVertexArray(s_pendingDraws[begin].vertexArray);
+        glMultiDrawElementsIndirect(GL_TRIANGLES, s_pendingDraws[begin].indexType,
+                                    reinterpret_cast<const void*>(begin * sizeof(DrawElementsIndirectCommand)),
+                                    static_cast<GLsizei>(end - begin), 0);
+        begin = end;
+    }
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void ChunkRenderer::drawBaseVertex() {
+    // baseInstance が使えないので、チャンクの原点は属性配列を使わない頂点属性の値として渡す
+    GLuint boundVertexArray = 0;
+    for (size_t begin = 0; begin < s_pendingDraws.size();) {
+        const PendingDraw& head = s_pendingDraws[begin];
+        const size_t indexSize = (head.indexType == GL_UNSIGNED_SHORT) ? sizeof(GLushort) : sizeof(GLuint);
+        s_drawCounts.clear();
+        s_drawIndexOffsets.clear();
+        s_drawBaseVertices.clear();
+        size_t end = begin;
+        while (end < s_pendingDraws.size() && s_pendingDraws[end].command.baseInstance == head.command.baseInstance) {
+            const DrawElementsIndirectCommand& command = s_pendingDraws[end].command;
+            s_drawCounts.push_back(static_cast<GLsizei>(command.count));
+            s_drawIndexOffsets.push_back(reinterpret_cast<const void*>(static_cast<size_t>(command.firstIndex) * indexSize));
+            s_drawBaseVertices.push_back(command.baseVertex);
+            ++end;
+        }
+
+        if (head.vertexArray != boundVertexArray) {
+            glBindVertexArray(head.vertexArray);
+            boundVertexArray = head.vertexArray;
+        }
+        const glm::ivec3& origin = s_chunkOrigins[head.command.baseInstance];
+        glVertexAttribI3i(1, origin.x, origin.y, origin.z);
+        glMultiDrawElementsBaseVertex(GL_TRIANGLES, s_drawCounts.data(), head.indexType, s_drawIndexOffsets.data(),
+                                      static_cast<GLsizei>(s_drawCounts.size()), s_drawBaseVertices.data());
+        begin = end;
+    }
+}
+
+void ChunkRenderer::releaseSharedBuffers() {
+    s_meshArena.release();
+    if (s_chunkOriginBuffer != 0) glDeleteBuffers(1, &s_chunkOriginBuffer);
+    if (s_indirectBuffer != 0) glDeleteBuffers(1, &s_indirectBuffer);
+    s_chunkOriginBuffer = 0;
+    s_indirectBuffer = 0;
+    s_indirectDrawSupported = -1;
+    if (s_quadIndexBuffer16 != 0) glDeleteBuffers(1, &s_quadIndexBuffer16);
+    if (s_quadIndexBuffer32 != 0) glDeleteBuffers(1, &s_quadIndexBuffer32);
+    s_quadIndexBuffer16 = 0;
+    s_quadIndexBuffer32 = 0;
+    s_quadCapacity32 = 0;
+}
+
+// 呼び出し時に VAO がバインドされていると、GL_ELEMENT_ARRAY_BUFFER のバインドがその VAO の状態を変えてしまう
+GLuint ChunkRenderer::getQuadIndexBuffer(size_t quadCount, GLenum& indexType) {
+    if (quadCount <= MAX_QUADS_16BIT) {
+        indexType = GL_UNSIGNED_SHORT;
+        if (s_quadIndexBuffer16 == 0) {
+            // 16bit 版は表現できる上限まで一度だけ作成する (約 192KB)
+            std::vector<std::uint16_t> indices = buildQuadIndices<std::uint16_t>(MAX_QUADS_16BIT);
+            glGenBuffers(1, &s_quadIndexBuffer16);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_quadIndexBuffer16);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint16_t), indices.data(), GL_STATIC_DRAW);
+        }
+        return s_quadIndexBuffer16;
+    }
+
+    indexType = GL_UNSIGNED_INT;
+    if (s_quadIndexBuffer32 == 0) {
+        glGenBuffers(1, &s_quadIndexBuffer32);
+    }
+    if (quadCount > s_quadCapacity32) {
+        // 同じバッファ名のままデータを作り直すので、既存の VAO からの参照はそのまま有効
+        size_t newCapacity = s_quadCapacity32 == 0 ? MAX_QUADS_16BIT * 2 : s_quadCapacity32;
+        while (newCapacity < quadCount) {
+            newCapacity *= 2;
+        }
+        std::vector<std::uint32_t> indices = buildQuadIndices<std::uint32_t>(newCapacity);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_quadIndexBuffer32);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(std::uint32_t), indices.data(), GL_STATIC_DRAW);
+        s_quadCapacity32 = newCapacity;
+        std::cout << "ChunkRenderer: grew shared 32-bit quad index buffer to " << newCapacity << " quads." << std::endl;
+    }
+    return s_quadIndexBuffer32;
+}
@@ -2,15 +2,90 @@
 #ifndef CHUNK_RENDERER_HPP
 #define CHUNK_RENDERER_HPP
 
+#include <cstddef>
+#include <vector>
 #include <glad/glad.h>
 #include "renderer.hpp" // ChunkRenderData の定義を含む
 #include "chunk_mesh_generator.hpp" // ChunkMeshData の定義を含む
+#include "chunk_mesh_arena.hpp"
 
 class ChunkRenderer {
 public:
     // ChunkMeshData から OpenGL 用の ChunkRenderData を生成する
-    // この関数はGPUリソースを作成します
+    // 頂点は全チャンク共有の頂点バッファ (ChunkMeshArena) の空き領域へ転送する
     static ChunkRenderData createChunkRenderData(const ChunkMeshData& meshData);
+
+    // items の見える面を描画する (シェーダーとテクスチャは呼び出し側で設定しておくこと)
+    // 見える向きの連続した範囲ごとに描画コマンドを作り、同じ VAO のコマンドをまとめて発行する
+    // OpenGL 4.3 では VAO ごとに glMultiDrawElementsIndirect 1回、
+    // それ以外ではチャンクごとに glMultiDrawElementsBaseVertex 1回で描画する
+    static void drawChunks(const std::vector<ChunkDrawItem>& items);
+
+    // 共有頂点バッファの隙間を詰める。maxBytes 以下のメッシュを1つ移動し、移動したバイト数を返す (なければ 0)
+    static size_t defragmentMeshes(size_t maxBytes) { return s_meshArena.defragmentStep(maxBytes); }
+
+    // 全チャンクで共有している頂点バッファ・四角形用インデックスバッファ・描画コマンド用バッファを解放する
+    // OpenGL コンテキストを破棄する前に呼ぶこと
+    static void releaseSharedBuffers();
+
+private:
+    friend struct ChunkRenderData; // デストラクタからメッシュの領域を返すため
+
+    // 全チャンクのメッシュの頂点を格納する共有頂点バッファ
+    static ChunkMeshArena s_meshArena;
+
+    // 描画に使う VAO と、その頂点バッファ内でのメッシュの開始位置 (glDrawElementsBaseVertex の baseVertex)
+    // デフラグでメッシュが移動することがあるので、描画のたびに取得すること
+    struct DrawInfo {
+        GLuint vertexArray;
+        GLint baseVertex;
+    };
+    static DrawInfo getDrawInfo(const ChunkRenderData& renderData);
+
+    // glMultiDrawElementsIndirect が読むコマンドの形式 (OpenGL の仕様で決まっている)
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance; // チャンク原点バッファ内の原点の番号
+    };
+
+    struct PendingDraw {
+        GLuint vertexArray;
+        GLenum indexType;
+        DrawElementsIndirectCommand command;
+    };
+
+    // glMultiDrawElementsIndirect を使うかどうか (初回の drawChunks で決める。-1 は未判定)
+    static int s_indirectDrawSupported;
+    // チャンク原点 (ivec3) を描画順に並べたバッファと、描画コマンドのバッファ (毎フレーム作り直す)
+    static GLuint s_chunkOriginBuffer;
+    static GLuint s_indirectBuffer;
+    // フレームごとの作業用配列 (確保し直さないよう使い回す)
+    static std::vector<glm::ivec3> s_chunkOrigins;
+    static std::vector<PendingDraw> s_pendingDraws;
+    static std::vector<DrawElementsIndirectCommand> s_indirectCommands;
+    static std::vector<GLsizei> s_drawCounts;
+    static std::vector<const void*> s_drawIndexOffsets;
+    static std::vector<GLint> s_drawBaseVertices;
+
+    static void drawIndirect();
+    static void drawBaseVertex();
+
+    // 16bit インデックスで参照できる最大の四角形数 (頂点番号 65535 まで)
+    static constexpr size_t MAX_QUADS_16BIT = 65536 / 4;
+
+    // 四角形ごとに 0,1,2 / 0,2,3 (+4k) を並べたインデックスバッファ
+    // どのチャンクでも内容は同じなので、1つを全チャンクの VAO で共有する
+    static GLuint s_quadIndexBuffer16;
+    static GLuint s_quadIndexBuffer32;
+    static size_t s_quadCapacity32;
+
+    // quadCount 枚の四角形を描画できる共有インデックスバッファを返す
+    // 16bit で足りる場合は 16bit 版を使い、足りない場合は 32bit 版を必要なだけ拡張する
+    // (baseVertex で各メッシュの先頭を指定するので、インデックスはメッシュ内の頂点番号でよい)
+    static GLuint getQuadIndexBuffer(size_t quadCount, GLenum& indexType);
 };
 
-#endif // CHUNK_RENDERER_HPP
\ No newline at end of file
+#endif // CHUNK_RENDERER_HPP
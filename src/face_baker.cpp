@@ -2,15 +2,15 @@
 #include "mesh_types.hpp" // FaceBaker.hpp でインクルードされるため、ここでの明示的なインクルードは必須ではありませんが、明示的に含めても問題ありません。
 
 // 定義は引き続き.cppファイルに保持
-const std::vector<Vertex> baseCubeVertices = {
-    {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // 0: Back-bottom-left (Z-)
-    {1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // 1: Back-bottom-right (Z-)
-    {1.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // 2: Back-top-right (Z-)
-    {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // 3: Back-top-left (Z-)
-    {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // 4: Front-top-right (Z+)
-    {1.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // 5: Front-bottom-right (Z+)
-    {0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}, // 6: Front-bottom-left (Z+)
-    {0.0f, 1.0f, 1.0f, 0.5f, 0.5f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f}  // 7: Front-top-left (Z+)
+const std::array<glm::ivec3, 8> baseCubeVertices = {
+    glm::ivec3(0, 0, 0), // 0: Back-bottom-left (Z-)
+    glm::ivec3(1, 0, 0), // 1: Back-bottom-right (Z-)
+    glm::ivec3(1, 1, 0), // 2: Back-top-right (Z-)
+    glm::ivec3(0, 1, 0), // 3: Back-top-left (Z-)
+    glm::ivec3(1, 1, 1), // 4: Front-top-right (Z+)
+    glm::ivec3(1, 0, 1), // 5: Front-bottom-right (Z+)
+    glm::ivec3(0, 0, 1), // 6: Front-bottom-left (Z+)
+    glm::ivec3(0, 1, 1)  // 7: Front-top-left (Z+)
 };
 
 const std::array<std::array<unsigned int, 4>, 6> cubeFaceBaseIndices = {
@@ -31,11 +31,11 @@ const std::array<glm::vec3, 6> faceNormals = {
     glm::vec3(0.0f, 1.0f, 0.0f)   // 5: Top face (Y+)
 };
 
-const std::array<glm::vec2, 4> faceUVs = {
-    glm::vec2(0.0f, 0.0f), // 左下 (bottom-left)
-    glm::vec2(1.0f, 0.0f), // 右下 (bottom-right)
-    glm::vec2(1.0f, 1.0f), // 右上 (top-right)
-    glm::vec2(0.0f, 1.0f)  // 左上 (top-left)
+const std::array<glm::ivec2, 4> faceUVs = {
+    glm::ivec2(0, 0), // 左下 (bottom-left)
+    glm::ivec2(1, 0), // 右下 (bottom-right)
+    glm::ivec2(1, 1), // 右上 (top-right)
+    glm::ivec2(0, 1)  // 左上 (top-left)
 };
 
 
@@ -44,8 +44,8 @@ FaceBaker::FaceBaker(const VoxelAccessor& accessor, int chunkSize)
 {
 }
 
-float FaceBaker::calculateAmbientOcclusion(int x, int y, int z,
-                                         float cornerDX, float cornerDY, float cornerDZ,
+int FaceBaker::calculateAmbientOcclusion(int x, int y, int z,
+                                         int cornerDX, int cornerDY, int cornerDZ,
                                          int faceIndex) const
 {
     int side1_dx = 0, side1_dy = 0, side1_dz = 0;
@@ -58,8 +58,8 @@ float FaceBaker::calculateAmbientOcclusion(int x, int y, int z,
     // X- 面 (左) のAO (Normal: (-1, 0, 0))
     if (faceIndex == 2)
     {
-        side1_dy = (cornerDY == 0.0f) ? -1 : 1;
-        side2_dz = (cornerDZ == 0.0f) ? -1 : 1;
+        side1_dy = (cornerDY == 0) ? -1 : 1;
+        side2_dz = (cornerDZ == 0) ? -1 : 1;
         corner_dy = side1_dy;
         corner_dz = side2_dz;
     }
@@ -67,16 +67,16 @@ float FaceBaker::calculateAmbientOcclusion(int x, int y, int z,
     else if (faceIndex == 3)
     {
         x = x + 1; // 隣接ボクセルは常にx+1の方向にある
-        side1_dy = (cornerDY == 0.0f) ? -1 : 1;
-        side2_dz = (cornerDZ == 0.0f) ? -1 : 1;
+        side1_dy = (cornerDY == 0) ? -1 : 1;
+        side2_dz = (cornerDZ == 0) ? -1 : 1;
         corner_dy = side1_dy;
         corner_dz = side2_dz;
     }
     // Y- 面 (底) のAO (Normal: (0, -1, 0))
     else if (faceIndex == 4)
     {
-        side1_dx = (cornerDX == 0.0f) ? -1 : 1;
-        side2_dz = (cornerDZ == 0.0f) ? -1 : 1;
+        side1_dx = (cornerDX == 0) ? -1 : 1;
+        side2_dz = (cornerDZ == 0) ? -1 : 1;
         corner_dx = side1_dx;
         corner_dz = side2_dz;
     }
@@ -84,16 +84,16 @@ float FaceBaker::calculateAmbientOcclusion(int x, int y, int z,
     else if (faceIndex == 5)
     {
         y = y + 1; // 隣接ボクセルは常にy+1の方向にある
-        side1_dx = (cornerDX == 0.0f) ? -1 : 1;
-        side2_dz = (cornerDZ == 0.0f) ? -1 : 1;
+        side1_dx = (cornerDX == 0) ? -1 : 1;
+        side2_dz = (cornerDZ == 0) ? -1 : 1;
         corner_dx = side1_dx;
         corner_dz = side2_dz;
     }
     // Z- 面 (奥) のAO (Normal: (0, 0, -1))
     else if (faceIndex == 0)
     {
-        side1_dx = (cornerDX == 0.0f) ? -1 : 1;
-        side2_dy = (cornerDY == 0.0f) ? -1 : 1;
+        side1_dx = (cornerDX == 0) ? -1 : 1;
+        side2_dy = (cornerDY == 0) ? -1 : 1;
         corner_dx = side1_dx;
         corner_dy = side2_dy;
     }
@@ -101,8 +101,8 @@ float FaceBaker::calculateAmbientOcclusion(int x, int y, int z,
     else if (faceIndex == 1)
     {
         z = z + 1; // 隣接ボクセルは常にz+1の方向にある
-        side1_dx = (cornerDX == 0.0f) ? -1 : 1;
-        side2_dy = (cornerDY == 0.0f) ? -1 : 1;
+        side1_dx = (cornerDX == 0) ? -1 : 1;
+        side2_dy = (cornerDY == 0) ? -1 : 1;
         corner_dx = side1_dx;
         corner_dy = side2_dy;
     }
@@ -115,37 +115,43 @@ float FaceBaker::calculateAmbientOcclusion(int x, int y, int z,
     // 0fps のAO値を計算
     if (side1_solid && side2_solid && corner_solid)
     {
-        return 0.0f; // 最も暗い
+        return 0; // 最も暗い
     }
     else if ((side1_solid && side2_solid) || (side1_solid && corner_solid) || (side2_solid && corner_solid))
     {
-        return 1.0f;
+        return 1;
     }
     else if (side1_solid || side2_solid || corner_solid)
     {
-        return 2.0f;
+        return 2;
     }
     else
     {
-        return 3.0f; // 最も明るい
+        return 3; // 最も明るい
     }
 }
 
-glm::vec2 FaceBaker::transformUV(const glm::vec2& uv, int rotationAmount, bool flipHorizontal) const
+// uv は [0, tileCount] の範囲 (結合された面ではテクスチャを繰り返す)
+// 回転・反転はタイルごとに適用されるよう、範囲全体に対して行う
+glm::ivec2 FaceBaker::transformUV(const glm::ivec2& uv, const glm::ivec2& tileCount,
+                                  int rotationAmount, bool flipHorizontal) const
 {
-    glm::vec2 transformedUV = uv;
+    glm::ivec2 transformedUV = uv;
+    int extentU = tileCount.x; // 回転後の U 方向の範囲
 
     // まず回転を適用
     switch (rotationAmount)
     {
     case 1: // 90度回転 (反時計回り)
-        transformedUV = glm::vec2(1.0f - uv.y, uv.x);
+        transformedUV = glm::ivec2(tileCount.y - uv.y, uv.x);
+        extentU = tileCount.y;
         break;
     case 2: // 180度回転
-        transformedUV = glm::vec2(1.0f - uv.x, 1.0f - uv.y);
+        transformedUV = glm::ivec2(tileCount.x - uv.x, tileCount.y - uv.y);
         break;
     case 3: // 270度回転 (反時計回り)
-        transformedUV = glm::vec2(uv.y, 1.0f - uv.x);
+        transformedUV = glm::ivec2(uv.y, tileCount.x - uv.x);
+        extentU = tileCount.y;
         break;
     default: // 0度回転 (case 0)
         // 何もしない
@@ -155,51 +161,49 @@ glm::vec2 FaceBaker::transformUV(const glm::vec2& uv, int rotationAmount, bool f
     // 次に水平反転を適用 (U座標のみ反転)
     if (flipHorizontal)
     {
-        transformedUV.x = 1.0f - transformedUV.x;
+        transformedUV.x = extentU - transformedUV.x;
     }
     return transformedUV;
 }
 
-void FaceBaker::bakeFace(ChunkMeshData& meshData, int x, int y, int z, int faceIndex,
-                         int rotationAmount, bool flipHorizontal)
+std::array<int, 4> FaceBaker::computeFaceAO(int x, int y, int z, int faceIndex) const
 {
-    size_t currentVertexCount = meshData.vertices.size();
-    glm::vec3 currentFaceNormal = faceNormals[faceIndex];
-
-    for (int v_idx = 0; v_idx < 4; ++v_idx) // 4つの頂点についてループ
+    std::array<int, 4> ao;
+    for (int v_idx = 0; v_idx < 4; ++v_idx)
     {
-        unsigned int baseIdx = cubeFaceBaseIndices[faceIndex][v_idx];
-        Vertex baseVertex = baseCubeVertices[baseIdx];
+        const glm::ivec3 &corner = baseCubeVertices[cubeFaceBaseIndices[faceIndex][v_idx]];
+        ao[v_idx] = calculateAmbientOcclusion(x, y, z, corner.x, corner.y, corner.z, faceIndex);
+    }
+    return ao;
+}
 
-        Vertex newVertex = baseVertex;
-        newVertex.x += x;
-        newVertex.y += y;
-        newVertex.z += z;
+void FaceBaker::bakeFace(ChunkMeshData& meshData, int x, int y, int z, int faceIndex, int textureLayer,
+                         int rotationAmount, bool flipHorizontal)
+{
+    bakeQuad(meshData, x, y, z, faceIndex, glm::ivec3(1), textureLayer, rotationAmount, flipHorizontal,
+             computeFaceAO(x, y, z, faceIndex));
+}
 
-        // ここで元のUV座標を取得し、変換関数を適用
-        glm::vec2 uv = transformUV(faceUVs[v_idx], rotationAmount, flipHorizontal);
+void FaceBaker::bakeQuad(ChunkMeshData& meshData, int x, int y, int z, int faceIndex,
+                         const glm::ivec3& extent, int textureLayer, int rotationAmount, bool flipHorizontal,
+                         const std::array<int, 4>& ao)
+{
+    const std::array<unsigned int, 4> &faceCorners = cubeFaceBaseIndices[faceIndex];
 
-        newVertex.u = uv.x;
-        newVertex.v = uv.y;
+    // UV の U は頂点0→1、V は頂点1→2 の辺に沿う。結合された面ではその辺の長さ分だけタイルを繰り返す
+    glm::ivec3 edgeU = glm::abs(baseCubeVertices[faceCorners[1]] - baseCubeVertices[faceCorners[0]]);
+    glm::ivec3 edgeV = glm::abs(baseCubeVertices[faceCorners[2]] - baseCubeVertices[faceCorners[1]]);
+    glm::ivec2 tileCount(glm::dot(glm::vec3(edgeU), glm::vec3(extent)),
+                         glm::dot(glm::vec3(edgeV), glm::vec3(extent)));
 
-        newVertex.nx = currentFaceNormal.x;
-        newVertex.ny = currentFaceNormal.y;
-        newVertex.nz = currentFaceNormal.z;
+    const glm::ivec3 origin(x, y, z);
+    for (int v_idx = 0; v_idx < 4; ++v_idx) // 4つの頂点についてループ
+    {
+        glm::ivec3 position = origin + baseCubeVertices[faceCorners[v_idx]] * extent;
 
-        // AO値を計算して設定
-        newVertex.ao = calculateAmbientOcclusion(x, y, z,
-                                                 baseVertex.x, baseVertex.y, baseVertex.z,
-                                                 faceIndex);
+        // ここで元のUV座標を取得し、変換関数を適用
+        glm::ivec2 uv = transformUV(faceUVs[v_idx] * tileCount, tileCount, rotationAmount, flipHorizontal);
 
-        meshData.vertices.push_back(newVertex);
+        meshData.vertices.push_back(packVertex(position, faceIndex, ao[v_idx], uv, textureLayer));
     }
-
-    // インデックスは常に同じ順序
-    meshData.indices.push_back(static_cast<unsigned int>(currentVertexCount) + 0);
-    meshData.indices.push_back(static_cast<unsigned int>(currentVertexCount) + 1);
-    meshData.indices.push_back(static_cast<unsigned int>(currentVertexCount) + 2);
-
-    meshData.indices.push_back(static_cast<unsigned int>(currentVertexCount) + 0);
-    meshData.indices.push_back(static_cast<unsigned int>(currentVertexCount) + 2);
-    meshData.indices.push_back(static_cast<unsigned int>(currentVertexCount) + 3);
 }
\ No newline at end of file
@@ -8,11 +8,10 @@
 #include <vector> // std::vector のために追加
 
 // 既存の定数。これらの定義はface_baker.cppにあり、ここではextern宣言として機能します。
-// ただし、Vertexが定義された後でなければならない。
-extern const std::vector<Vertex> baseCubeVertices;
+extern const std::array<glm::ivec3, 8> baseCubeVertices;
 extern const std::array<std::array<unsigned int, 4>, 6> cubeFaceBaseIndices;
 extern const std::array<glm::vec3, 6> faceNormals;
-extern const std::array<glm::vec2, 4> faceUVs;
+extern const std::array<glm::ivec2, 4> faceUVs;
 
 class FaceBaker
 {
@@ -20,20 +19,31 @@ public:
     explicit FaceBaker(const VoxelAccessor& accessor, int chunkSize);
 
     // 単一の面を生成し、頂点データをmeshDataに追加
-    void bakeFace(ChunkMeshData& meshData, int x, int y, int z, int faceIndex,
+    // textureLayer はブロック用テクスチャ配列のレイヤー (getBlockTextureLayer)
+    void bakeFace(ChunkMeshData& meshData, int x, int y, int z, int faceIndex, int textureLayer,
                   int rotationAmount, bool flipHorizontal);
 
+    // (x, y, z) を起点に extent (法線方向は 1) の大きさを持つ結合済みの面を生成
+    // テクスチャは extent に合わせてタイル状に繰り返される
+    void bakeQuad(ChunkMeshData& meshData, int x, int y, int z, int faceIndex,
+                  const glm::ivec3& extent, int textureLayer, int rotationAmount, bool flipHorizontal,
+                  const std::array<int, 4>& ao);
+
+    // 面の4頂点のAO値を頂点順に計算
+    std::array<int, 4> computeFaceAO(int x, int y, int z, int faceIndex) const;
+
 private:
     const VoxelAccessor& voxelAccessor_;
     int chunkSize_;
 
     // アンビエントオクルージョン値を計算
-    float calculateAmbientOcclusion(int x, int y, int z,
-                                    float cornerDX, float cornerDY, float cornerDZ,
-                                    int faceIndex) const;
+    int calculateAmbientOcclusion(int x, int y, int z,
+                                  int cornerDX, int cornerDY, int cornerDZ,
+                                  int faceIndex) const;
 
     // UV座標を回転・反転
-    glm::vec2 transformUV(const glm::vec2& uv, int rotationAmount, bool flipHorizontal) const;
+    glm::ivec2 transformUV(const glm::ivec2& uv, const glm::ivec2& tileCount,
+                           int rotationAmount, bool flipHorizontal) const;
 };
 
 #endif // FACE_BAKER_HPP
\ No newline at end of file
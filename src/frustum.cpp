@@ -0,0 +1,80 @@
+#include "frustum.hpp"
+
+Frustum::Frustum()
+{
+    // 法線・距離が 0 の平面は全ての点で 0 となり、どの AABB も除外しない
+    for (Plane &plane : m_planes)
+    {
+        plane.normal = glm::vec3(0.0f);
+        plane.distance = 0.0f;
+    }
+}
+
+void Frustum::update(const glm::mat4 &viewProjection)
+{
+    m_planes[0].normal = glm::vec3(viewProjection[0][3] - viewProjection[0][0],
+                                   viewProjection[1][3] - viewProjection[1][0],
+                                   viewProjection[2][3] - viewProjection[2][0]);
+    m_planes[0].distance = viewProjection[3][3] - viewProjection[3][0];
+
+    m_planes[1].normal = glm::vec3(viewProjection[0][3] + viewProjection[0][0],
+                                   viewProjection[1][3] + viewProjection[1][0],
+                                   viewProjection[2][3] + viewProjection[2][0]);
+    m_planes[1].distance = viewProjection[3][3] + viewProjection[3][0];
+
+    m_planes[2].normal = glm::vec3(viewProjection[0][3] + viewProjection[0][1],
+                                   viewProjection[1][3] + viewProjection[1][1],
+                                   viewProjection[2][3] + viewProjection[2][1]);
+    m_planes[2].distance = viewProjection[3][3] + viewProjection[3][1];
+
+    m_planes[3].normal = glm::vec3(viewProjection[0][3] - viewProjection[0][1],
+                                   viewProjection[1][3] - viewProjection[1][1],
+                                   viewProjection[2][3] - viewProjection[2][1]);
+    m_planes[3].distance = viewProjection[3][3] - viewProjection[3][1];
+
+    m_planes[4].normal = glm::vec3(viewProjection[0][3] - viewProjection[0][2],
+                                   viewProjection[1][3] - viewProjection[1][2],
+                                   viewProjection[2][3] - viewProjection[2][2]);
+    m_planes[4].distance = viewProjection[3][3] - viewProjection[3][2];
+
+    m_planes[5].normal = glm::vec3(viewProjection[0][3] + viewProjection[0][2],
+                                   viewProjection[1][3] + viewProjection[1][2],
+                                   viewProjection[2][3] + viewProjection[2][2]);
+    m_planes[5].distance = viewProjection[3][3] + viewProjection[3][2];
+
+    for (int i = 0; i < 6; ++i)
+    {
+        float length = glm::length(m_planes[i].normal);
+        m_planes[i].normal /= length;
+        m_planes[i].distance /= length;
+    }
+}
+
+bool Frustum::isBoxVisible(const glm::vec3 &minPoint, const glm::vec3 &maxPoint) const
+{
+    for (int i = 0; i < 6; ++i)
+    {
+        const Plane &p = m_planes[i];
+
+        // 平面の法線方向に最も進んだ頂点 (p-vertex) が裏側にあれば AABB 全体が外側
+        glm::vec3 p_vertex = minPoint;
+        if (p.normal.x >= 0)
+        {
+            p_vertex.x = maxPoint.x;
+        }
+        if (p.normal.y >= 0)
+        {
+            p_vertex.y = maxPoint.y;
+        }
+        if (p.normal.z >= 0)
+        {
+            p_vertex.z = maxPoint.z;
+        }
+
+        if (glm::dot(p.normal, p_vertex) + p.distance < 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
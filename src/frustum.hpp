@@ -0,0 +1,36 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <array>
+#include <glm/glm.hpp>
+
+// Represents a plane in the form Ax + By + Cz + D = 0
+struct Plane
+{
+    glm::vec3 normal;
+    float distance; // Distance from origin
+};
+
+// ビュー・プロジェクション行列から求めた視錐台 (6平面)
+// 平面を一度も設定していない状態では全ての AABB を可視とみなす
+class Frustum
+{
+public:
+    Frustum();
+
+    // ビュー・プロジェクション行列から6平面を抽出する
+    void update(const glm::mat4 &viewProjection);
+
+    // AABB が視錐台と交差する (または内側にある) かどうか
+    bool isBoxVisible(const glm::vec3 &minPoint, const glm::vec3 &maxPoint) const;
+
+    // 正規化済みの6平面 (法線は視錐台の内側を向く)
+    const std::array<Plane, 6> &getPlanes() const { return m_planes; }
+    // 視線方向 (近平面の法線)。平面を設定していない状態では 0 ベクトル
+    glm::vec3 getForward() const { return m_planes[5].normal; }
+
+private:
+    std::array<Plane, 6> m_planes;
+};
+
+#endif // FRUSTUM_HPP
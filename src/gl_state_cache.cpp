@@ -0,0 +1,94 @@
+#include "gl_state_cache.hpp"
+
+GLuint GlStateCache::s_program = 0;
+GLuint GlStateCache::s_texture2D = 0;
+GLuint GlStateCache::s_texture2DArray = 0;
+bool GlStateCache::s_programKnown = false;
+bool GlStateCache::s_texture2DKnown = false;
+bool GlStateCache::s_texture2DArrayKnown = false;
+int GlStateCache::s_depthTest = -1;
+int GlStateCache::s_cullFace = -1;
+int GlStateCache::s_blend = -1;
+
+void GlStateCache::useProgram(GLuint program)
+{
+    if (s_programKnown && s_program == program)
+    {
+        return;
+    }
+    glUseProgram(program);
+    s_program = program;
+    s_programKnown = true;
+}
+
+void GlStateCache::bindTexture2D(GLuint texture)
+{
+    if (s_texture2DKnown && s_texture2D == texture)
+    {
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    s_texture2D = texture;
+    s_texture2DKnown = true;
+}
+
+void GlStateCache::bindTexture2DArray(GLuint texture)
+{
+    if (s_texture2DArrayKnown && s_texture2DArray == texture)
+    {
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    s_texture2DArray = texture;
+    s_texture2DArrayKnown = true;
+}
+
+void GlStateCache::setEnabled(GLenum capability, bool enabled)
+{
+    int *state = findCapability(capability);
+    int value = enabled ? 1 : 0;
+    if (state && *state == value)
+    {
+        return;
+    }
+    if (enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+    if (state)
+    {
+        *state = value;
+    }
+}
+
+void GlStateCache::invalidate()
+{
+    s_programKnown = false;
+    s_texture2DKnown = false;
+    s_texture2DArrayKnown = false;
+    s_depthTest = -1;
+    s_cullFace = -1;
+    s_blend = -1;
+}
+
+// 記録の対象外の設定は nullptr (毎回 GL を呼ぶ)
+int *GlStateCache::findCapability(GLenum capability)
+{
+    switch (capability)
+    {
+    case GL_DEPTH_TEST:
+        return &s_depthTest;
+    case GL_CULL_FACE:
+        return &s_cullFace;
+    case GL_BLEND:
+        return &s_blend;
+    default:
+        return nullptr;
+    }
+}
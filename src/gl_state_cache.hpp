@@ -0,0 +1,38 @@
+#ifndef GL_STATE_CACHE_HPP
+#define GL_STATE_CACHE_HPP
+
+#include <glad/glad.h>
+
+// 現在の OpenGL の状態 (プログラム・テクスチャ・有効/無効の設定) を覚えておき、
+// 既に同じ状態なら GL の呼び出しを省く。
+// ここを通さずに状態を変えた場合や、コンテキストを作り直した場合は invalidate() を呼ぶこと
+class GlStateCache
+{
+public:
+    static void useProgram(GLuint program);
+    // テクスチャユニット 0 に GL_TEXTURE_2D をバインドする (このプロジェクトではユニット 0 しか使わない)
+    static void bindTexture2D(GLuint texture);
+    // テクスチャユニット 0 に GL_TEXTURE_2D_ARRAY をバインドする (GL_TEXTURE_2D とは別に記録する)
+    static void bindTexture2DArray(GLuint texture);
+    // GL_DEPTH_TEST / GL_CULL_FACE / GL_BLEND を切り替える
+    static void setEnabled(GLenum capability, bool enabled);
+
+    // 記録している状態を捨てる (次の呼び出しでは必ず GL を呼ぶ)
+    static void invalidate();
+
+private:
+    // 最後に設定した状態。有効/無効は -1: 不明, 0: 無効, 1: 有効
+    static GLuint s_program;
+    static GLuint s_texture2D;
+    static GLuint s_texture2DArray;
+    static bool s_programKnown;
+    static bool s_texture2DKnown;
+    static bool s_texture2DArrayKnown;
+    static int s_depthTest;
+    static int s_cullFace;
+    static int s_blend;
+
+    static int *findCapability(GLenum capability);
+};
+
+#endif // GL_STATE_CACHE_HPP
@@ -1,24 +1,59 @@
 #ifndef MESH_TYPES_HPP
 #define MESH_TYPES_HPP
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp> // 必要に応じて
 
 // Vertex 構造体の定義
+// 1頂点 8 バイトに詰めた形式。デコードは block_vertex_shader.glsl で行う。
+//   position: x(7bit) | y(7bit) << 7 | z(7bit) << 14 | 面番号(3bit) << 21 | AO(2bit) << 24
+//   texCoord: u(7bit) | v(7bit) << 7 | テクスチャのレイヤー(8bit) << 14
+// 座標はチャンクローカル (0〜size)。法線は面番号からシェーダー側で求める。
+// UV はタイル単位の整数で、テクスチャの回転・反転は適用済み (結合された面では範囲全体に適用する必要があるため)。
 struct Vertex
 {
-    float x, y, z;
-    float r, g, b;
-    float u, v;
-    float nx, ny, nz;
-    float ao; // AO値を格納する新しい属性
+    std::uint32_t position;
+    std::uint32_t texCoord;
 };
+static_assert(sizeof(Vertex) == 8, "Vertex must stay packed into 8 bytes");
+
+// 頂点の各成分のビット幅 (Chunk::MAX_SIZE (62) までの座標・UV を表現できる)
+constexpr int VERTEX_COORD_BITS = 7;
+constexpr std::uint32_t VERTEX_COORD_MASK = (1u << VERTEX_COORD_BITS) - 1;
+// テクスチャ配列のレイヤー番号のビット幅
+constexpr int VERTEX_TEXTURE_LAYER_BITS = 8;
+constexpr std::uint32_t VERTEX_TEXTURE_LAYER_MASK = (1u << VERTEX_TEXTURE_LAYER_BITS) - 1;
+
+inline Vertex packVertex(const glm::ivec3 &pos, int faceIndex, int ao, const glm::ivec2 &uv, int textureLayer)
+{
+    Vertex vertex;
+    vertex.position = (static_cast<std::uint32_t>(pos.x) & VERTEX_COORD_MASK) |
+                      ((static_cast<std::uint32_t>(pos.y) & VERTEX_COORD_MASK) << 7) |
+                      ((static_cast<std::uint32_t>(pos.z) & VERTEX_COORD_MASK) << 14) |
+                      ((static_cast<std::uint32_t>(faceIndex) & 7u) << 21) |
+                      ((static_cast<std::uint32_t>(ao) & 3u) << 24);
+    vertex.texCoord = (static_cast<std::uint32_t>(uv.x) & VERTEX_COORD_MASK) |
+                      ((static_cast<std::uint32_t>(uv.y) & VERTEX_COORD_MASK) << 7) |
+                      ((static_cast<std::uint32_t>(textureLayer) & VERTEX_TEXTURE_LAYER_MASK) << 14);
+    return vertex;
+}
+
+// 面の向きの数 (Z-, Z+, X-, X+, Y-, Y+ の順)
+constexpr int FACE_DIRECTION_COUNT = 6;
 
 // ChunkMeshData 構造体の定義
+// 頂点は4つずつで1枚の四角形 (0,1,2 / 0,2,3 の2三角形) を表す。
+// インデックスは全チャンク共通のパターンなので保持せず、ChunkRenderer の共有インデックスバッファを使う。
+// 頂点は面の向きごとに連続して並び、向き i の頂点は [faceVertexOffsets[i], faceVertexOffsets[i + 1]) にある。
 struct ChunkMeshData
 {
     std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
+    std::array<std::uint32_t, FACE_DIRECTION_COUNT + 1> faceVertexOffsets{};
+    // 全頂点を囲む AABB (チャンクローカル座標)。視錐台カリングでチャンク全体の箱の代わりに使う
+    glm::ivec3 boundsMin{0};
+    glm::ivec3 boundsMax{0};
 };
 
 #endif // MESH_TYPES_HPP
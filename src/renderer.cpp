@@ -1,4 +1,7 @@
 #include "renderer.hpp"
+#include "chunk_renderer.hpp"
+#include "gl_state_cache.hpp"
+#include "chunk/block_types.hpp"
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -13,7 +16,16 @@ extern GLuint createShaderProgram(const std::string& vertexPath, const std::stri
 
 
 Renderer::Renderer() : m_shaderProgram(0), m_textRenderer(), m_textureID(0),
-                       m_fogColorLoc(-1), m_fogStartLoc(-1), m_fogEndLoc(-1), m_fogDensityLoc(-1) {}
+                       m_frameUniformBuffer(0), m_frameUniforms(), m_sceneUniformsDirty(true)
+{
+    // ライティングとフォグの初期値
+    m_frameUniforms.lightDir = glm::vec3(0.5f, -1.0f, 0.5f); // 光源の方向 (例: 右上奥から手前下)
+    m_frameUniforms.ambientStrength = 0.3f; // 環境光の強さ
+    m_frameUniforms.fogColor = glm::vec3(0.5f, 0.5f, 0.7f); // 例: 少し青みがかったグレー
+    m_frameUniforms.fogStart = 50.0f;
+    m_frameUniforms.fogEnd = 500.0f;
+    m_frameUniforms.fogDensity = 0.005f;
+}
 
 Renderer::~Renderer()
 {
@@ -21,12 +33,17 @@ Renderer::~Renderer()
     if (m_textureID != 0) {
         glDeleteTextures(1, &m_textureID);
     }
+    if (m_frameUniformBuffer != 0) {
+        glDeleteBuffers(1, &m_frameUniformBuffer);
+    }
+    GlStateCache::invalidate(); // 削除したプログラムやテクスチャの名前が再利用されても取り違えないように
 }
 
 bool Renderer::initialize(const FontData &fontData)
 {
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
+    GlStateCache::invalidate();
+    GlStateCache::setEnabled(GL_DEPTH_TEST, true);
+    GlStateCache::setEnabled(GL_CULL_FACE, true);
     
     // シェーダーパスを block_vertex_shader.glsl と block_fragment_shader.glsl に変更
     // 実行ファイルがbuildディレクトリにある場合、src/shaders/への相対パスは ../src/shaders/ となります。
@@ -43,66 +60,85 @@ bool Renderer::initialize(const FontData &fontData)
         return false;
     }
 
-    if (!loadTexture("../textures/my_block_texture.png")) {
+    if (!loadBlockTextures("../textures/my_block_texture.png")) {
         std::cerr << "Failed to load block texture.\n";
         return false;
     }
 
     glUseProgram(m_shaderProgram);
     glUniform1i(glGetUniformLocation(m_shaderProgram, "ourTexture"), 0); // テクスチャユニット0を使用
+    glUseProgram(0);
 
-    // ライティング関連のユニフォーム初期値を設定
-    glUniform3f(glGetUniformLocation(m_shaderProgram, "lightDir"), 0.5f, -1.0f, 0.5f); // 光源の方向 (例: 右上奥から手前下)
-    glUniform1f(glGetUniformLocation(m_shaderProgram, "ambientStrength"), 0.3f); // 環境光の強さ
-
-    // フォグのユニフォームロケーションを取得
-    m_fogColorLoc = glGetUniformLocation(m_shaderProgram, "fogColor");
-    m_fogStartLoc = glGetUniformLocation(m_shaderProgram, "fogStart");
-    m_fogEndLoc = glGetUniformLocation(m_shaderProgram, "fogEnd");
-    m_fogDensityLoc = glGetUniformLocation(m_shaderProgram, "fogDensity");
-
-    // デフォルトのフォグパラメータをシェーダーに設定 (初期化時)
-    // Applicationクラスの初期値と一致させるか、ここでデフォルト値を設定
-    glUniform3f(m_fogColorLoc, 0.5f, 0.5f, 0.7f); // 例: 少し青みがかったグレー
-    glUniform1f(m_fogStartLoc, 50.0f);
-    glUniform1f(m_fogEndLoc, 500.0f);
-    glUniform1f(m_fogDensityLoc, 0.005f);
+    // 行列・フォグ・ライティングはユニフォームブロックでまとめて渡す
+    // バインディングポイントはこのブロック専用なので、バッファのバインドは初期化時の1回だけ
+    GLuint frameUniformsIndex = glGetUniformBlockIndex(m_shaderProgram, "FrameUniforms");
+    if (frameUniformsIndex == GL_INVALID_INDEX)
+    {
+        std::cerr << "FrameUniforms block not found in block shader program.\n";
+        return false;
+    }
+    glUniformBlockBinding(m_shaderProgram, frameUniformsIndex, FRAME_UNIFORMS_BINDING);
+    glGenBuffers(1, &m_frameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &m_frameUniforms, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, m_frameUniformBuffer);
+    m_sceneUniformsDirty = false;
 
-    glUseProgram(0);
+    // テクスチャの読み込みなどで状態を直接変えたので、記録を捨てておく
+    GlStateCache::invalidate();
 
     return true;
 }
 
-bool Renderer::loadTexture(const std::string& path) {
-    glGenTextures(1, &m_textureID);
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
-
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+// ブロック用のテクスチャ配列を作る
+// ブロックごとの画像はまだないので、共通の画像をレイヤーごとの色で乗算して各レイヤーにする
+// (石のレイヤーは画像そのまま)。画像を用意したら、そのレイヤーに読み込めばよい
+bool Renderer::loadBlockTextures(const std::string& path) {
+    static const std::array<glm::vec3, BLOCK_TEXTURE_LAYER_COUNT> layerTints = {
+        glm::vec3(1.0f, 1.0f, 1.0f),   // TEXTURE_LAYER_STONE
+        glm::vec3(0.62f, 0.45f, 0.3f), // TEXTURE_LAYER_DIRT
+        glm::vec3(0.45f, 0.8f, 0.35f), // TEXTURE_LAYER_GRASS_TOP
+        glm::vec3(0.55f, 0.6f, 0.38f), // TEXTURE_LAYER_GRASS_SIDE
+    };
 
     int width, height, nrChannels;
-    unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
-    if (data)
-    {
-        GLenum format = GL_RGB;
-        if (nrChannels == 4) {
-            format = GL_RGBA;
-        } else if (nrChannels == 3) {
-            format = GL_RGB;
-        }
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-        stbi_image_free(data);
-        return true;
-    }
-    else
+    unsigned char *data = stbi_load(path.c_str(), &width, &height, &nrChannels, 4); // 常に RGBA で読む
+    if (!data)
     {
         std::cerr << "Failed to load texture at path: " << path << std::endl;
-        if (data) stbi_image_free(data);
         return false;
     }
+
+    glGenTextures(1, &m_textureID);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, m_textureID);
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, width, height, BLOCK_TEXTURE_LAYER_COUNT, 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    std::vector<unsigned char> layerPixels(pixelCount * 4);
+    for (int layer = 0; layer < BLOCK_TEXTURE_LAYER_COUNT; ++layer)
+    {
+        const glm::vec3 &tint = layerTints[layer];
+        for (size_t i = 0; i < pixelCount; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                layerPixels[i * 4 + c] = static_cast<unsigned char>(data[i * 4 + c] * tint[c]);
+            }
+            layerPixels[i * 4 + 3] = data[i * 4 + 3];
+        }
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1,
+                        GL_RGBA, GL_UNSIGNED_BYTE, layerPixels.data());
+    }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    stbi_image_free(data);
+    return true;
 }
 
 void Renderer::beginFrame(const glm::vec4 &clearColor)
@@ -111,32 +147,29 @@ void Renderer::beginFrame(const glm::vec4 &clearColor)
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
-void Renderer::renderScene(const glm::mat4 &projection, const glm::mat4 &view, const ChunkRenderData &chunkRenderData, const glm::mat4 &model)
+void Renderer::renderChunks(const glm::mat4 &projection, const glm::mat4 &view, const std::vector<ChunkDrawItem> &items)
 {
-    if (chunkRenderData.VAO == 0 || chunkRenderData.indexCount == 0)
+    if (items.empty())
     {
         return;
     }
 
-    glUseProgram(m_shaderProgram);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, m_textureID);
-
-    glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-    glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-
-    // NormalMatrix を計算してシェーダーに渡す
-    // モデル行列の左上3x3部分を抽出して逆転置
-    glm::mat3 normalMatrix = glm::mat3(glm::transpose(glm::inverse(model)));
-    glUniformMatrix3fv(glGetUniformLocation(m_shaderProgram, "normalMatrix"), 1, GL_FALSE, glm::value_ptr(normalMatrix));
-
-    glBindVertexArray(chunkRenderData.VAO);
-    glDrawElements(GL_TRIANGLES, chunkRenderData.indexCount, GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
+    GlStateCache::useProgram(m_shaderProgram);
+    GlStateCache::bindTexture2DArray(m_textureID);
+    GlStateCache::setEnabled(GL_DEPTH_TEST, true);
+    GlStateCache::setEnabled(GL_CULL_FACE, true);
+    GlStateCache::setEnabled(GL_BLEND, false);
+
+    // チャンクごとの平行移動は頂点シェーダーでチャンク原点を足すので、モデル行列は使わない
+    // 行列は毎フレーム、フォグとライティングは変わったときだけ転送する
+    m_frameUniforms.view = view;
+    m_frameUniforms.projection = projection;
+    glBindBuffer(GL_UNIFORM_BUFFER, m_frameUniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, m_sceneUniformsDirty ? sizeof(FrameUniforms) : FRAME_MATRICES_SIZE, &m_frameUniforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_sceneUniformsDirty = false;
+
+    ChunkRenderer::drawChunks(items);
 }
 
 void Renderer::renderOverlay(int screenWidth, int screenHeight, const std::string &fpsString, const std::string &positionString)
@@ -160,15 +193,16 @@ void Renderer::endFrame() {
 // フォグパラメータ設定メソッドの実装
 void Renderer::setFogParameters(const glm::vec3& color, float start, float end, float density)
 {
-    // シェーダーが使用されていることを確認してからuniformを設定
-    // renderScene内で既にglUseProgram(m_shaderProgram);が呼ばれていることを前提とする
-    // もしrenderSceneの前にsetFogParametersが呼ばれる場合、ここでm_shaderProgram->use()が必要です。
-    // 今回はApplication::render()の呼び出し順序に合わせて、renderSceneの直前に呼び出すため、
-    // renderScene内でuse()されるm_shaderProgramがそのまま有効であると仮定します。
-    glUseProgram(m_shaderProgram); // 念のためここでuse()を呼ぶのが安全
-
-    glUniform3fv(m_fogColorLoc, 1, glm::value_ptr(color));
-    glUniform1f(m_fogStartLoc, start);
-    glUniform1f(m_fogEndLoc, end);
-    glUniform1f(m_fogDensityLoc, density);
+    // ここでは CPU 側の値を更新するだけで、転送は次の renderChunks で行う
+    // 毎フレーム同じ値で呼ばれても、変わっていなければ転送しない
+    if (m_frameUniforms.fogColor == color && m_frameUniforms.fogStart == start &&
+        m_frameUniforms.fogEnd == end && m_frameUniforms.fogDensity == density)
+    {
+        return;
+    }
+    m_frameUniforms.fogColor = color;
+    m_frameUniforms.fogStart = start;
+    m_frameUniforms.fogEnd = end;
+    m_frameUniforms.fogDensity = density;
+    m_sceneUniformsDirty = true;
 }
@@ -5,6 +5,8 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_inverse.hpp> // <- これを追加
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
@@ -13,42 +15,39 @@
 #include "opengl_utils.hpp" // createShaderProgram などが定義されていると仮定
 
 struct ChunkRenderData {
-    GLuint VAO = 0;
-    GLuint VBO = 0;
-    GLuint EBO = 0;
+    // 頂点は ChunkRenderer の共有頂点バッファ (ChunkMeshArena) 内の領域で、meshHandle がその領域を所有する
+    // インデックスバッファも ChunkRenderer が全チャンクで共有しているため、ここでは所有しない
+    std::uint32_t meshHandle = NO_MESH;
     GLsizei indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT; // GL_UNSIGNED_SHORT または GL_UNSIGNED_INT
+    // 面の向き i (Z-, Z+, X-, X+, Y-, Y+) のインデックス範囲は [faceIndexOffsets[i], faceIndexOffsets[i + 1])
+    std::array<GLsizei, 7> faceIndexOffsets{};
+    // メッシュの頂点を囲む AABB (チャンクローカル座標)
+    glm::ivec3 boundsMin{0};
+    glm::ivec3 boundsMax{0};
 
+    static constexpr std::uint32_t NO_MESH = 0xFFFFFFFFu;
+    bool hasMesh() const { return meshHandle != NO_MESH; }
+
+    // 領域の解放は ChunkRenderer が行う (定義は chunk_renderer.cpp)
     ChunkRenderData() = default;
-    ~ChunkRenderData() {
-        if (VAO != 0) glDeleteVertexArrays(1, &VAO);
-        if (VBO != 0) glDeleteBuffers(1, &VBO);
-        if (EBO != 0) glDeleteBuffers(1, &EBO);
-    }
+    ~ChunkRenderData();
     ChunkRenderData(const ChunkRenderData&) = delete;
     ChunkRenderData& operator=(const ChunkRenderData&) = delete;
     ChunkRenderData(ChunkRenderData&& other) noexcept
-        : VAO(other.VAO), VBO(other.VBO), EBO(other.EBO), indexCount(other.indexCount) {
-        other.VAO = 0;
-        other.VBO = 0;
-        other.EBO = 0;
+        : meshHandle(other.meshHandle), indexCount(other.indexCount), indexType(other.indexType),
+          faceIndexOffsets(other.faceIndexOffsets), boundsMin(other.boundsMin), boundsMax(other.boundsMax) {
+        other.meshHandle = NO_MESH;
         other.indexCount = 0;
     }
-    ChunkRenderData& operator=(ChunkRenderData&& other) noexcept {
-        if (this != &other) {
-            if (VAO != 0) glDeleteVertexArrays(1, &VAO);
-            if (VBO != 0) glDeleteBuffers(1, &VBO);
-            if (EBO != 0) glDeleteBuffers(1, &EBO);
-            VAO = other.VAO;
-            VBO = other.VBO;
-            EBO = other.EBO;
-            indexCount = other.indexCount;
-            other.VAO = 0;
-            other.VBO = 0;
-            other.EBO = 0;
-            other.indexCount = 0;
-        }
-        return *this;
-    }
+    ChunkRenderData& operator=(ChunkRenderData&& other) noexcept;
+};
+
+// 一括描画 (Renderer::renderChunks) に渡す、1チャンク分の描画内容
+struct ChunkDrawItem {
+    glm::ivec3 origin; // チャンクのワールド座標での原点 (ボクセル単位)
+    const ChunkRenderData* renderData;
+    unsigned int visibleFaceMask; // ビット i が立っている向きの面だけを描画する (面の順序は ChunkRenderData と同じ)
 };
 
 struct VoxelRenderInfo {
@@ -58,29 +57,48 @@ struct VoxelRenderInfo {
 class Renderer
 {
 public:
+    static constexpr unsigned int ALL_FACE_DIRECTIONS = 0x3F;
+
     Renderer();
     ~Renderer();
     bool initialize(const FontData &fontData);
     void beginFrame(const glm::vec4 &clearColor);
-    void renderScene(const glm::mat4 &projection, const glm::mat4 &view, const ChunkRenderData &chunkRenderData, const glm::mat4 &model);
+    // 見えるチャンクをまとめて描画する。シェーダー・テクスチャ・行列の設定はフレームに1回だけ行う
+    void renderChunks(const glm::mat4 &projection, const glm::mat4 &view, const std::vector<ChunkDrawItem> &items);
     void renderOverlay(int screenWidth, int screenHeight, const std::string &fpsString, const std::string &positionString);
     void endFrame();
 
     // フォグパラメータを設定する新しいメソッド
+    // 値が変わった場合だけ、次の renderChunks でシェーダーへ転送する
     void setFogParameters(const glm::vec3& color, float start, float end, float density);
 
 private:
+    // シェーダーの FrameUniforms ブロック (std140) と同じ並び。フレーム中は変わらない値をまとめて1回で転送する
+    struct FrameUniforms {
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::vec3 fogColor;
+        float fogStart;
+        glm::vec3 lightDir;
+        float fogEnd;
+        float fogDensity;
+        float ambientStrength;
+        float padding[2];
+    };
+    static_assert(sizeof(FrameUniforms) == 176, "FrameUniforms must match the std140 layout of the shader block");
+    // view と projection より後ろ (フォグ・ライティング) は変わったときだけ転送する
+    static constexpr size_t FRAME_MATRICES_SIZE = sizeof(glm::mat4) * 2;
+    static constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+
     GLuint m_shaderProgram;
     FontData m_fontData;
     TextRenderer m_textRenderer;
-    GLuint m_textureID;
-    bool loadTexture(const std::string& path);
+    GLuint m_textureID; // ブロック用のテクスチャ配列 (レイヤーは getBlockTextureLayer)
+    bool loadBlockTextures(const std::string& path);
 
-    // フォグのuniformロケーション
-    GLint m_fogColorLoc;
-    GLint m_fogStartLoc;
-    GLint m_fogEndLoc;
-    GLint m_fogDensityLoc;
+    GLuint m_frameUniformBuffer;
+    FrameUniforms m_frameUniforms;
+    bool m_sceneUniformsDirty; // フォグ・ライティングが前回の転送から変わったか
 };
 
 #endif // RENDERER_HPP
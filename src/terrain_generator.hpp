@@ -19,6 +19,8 @@ public:
 
     // ChunkManager から groundLevel にアクセスするためのゲッター
     int getGroundLevel() const { return m_groundLevel; }
+    // getTerrainHeight が返しうる最大の高さ
+    int getWorldMaxHeight() const { return m_worldMaxHeight; }
 
 private:
     std::unique_ptr<PerlinNoise2D> m_perlinNoise;
@@ -0,0 +1,37 @@
+#ifndef CANCELLATION_TOKEN_HPP
+#define CANCELLATION_TOKEN_HPP
+
+#include <atomic>
+#include <memory>
+
+// ジョブの協調的なキャンセルに使うトークン
+// コピーは同じ状態を共有するので、発行側 (メインスレッド) が cancel() すると
+// ジョブ側 (ワーカースレッド) の isCancelled() が true になる。
+// ジョブは開始時や処理の区切りで isCancelled() を確認し、true なら結果を捨てて早期に終了する。
+// 既定構築したトークンは状態を持たず (確保なし)、キャンセルされることもない。ジョブに渡すものは create() で作る。
+class CancellationToken
+{
+public:
+    CancellationToken() = default;
+
+    static CancellationToken create()
+    {
+        CancellationToken token;
+        token.m_cancelled = std::make_shared<std::atomic<bool>>(false);
+        return token;
+    }
+
+    void cancel() const
+    {
+        if (m_cancelled)
+        {
+            m_cancelled->store(true, std::memory_order_relaxed);
+        }
+    }
+    bool isCancelled() const { return m_cancelled && m_cancelled->load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> m_cancelled;
+};
+
+#endif // CANCELLATION_TOKEN_HPP
@@ -0,0 +1,79 @@
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// 複数スレッドから push し、1つのスレッドだけが取り出すロックフリーのキュー
+// push は先頭ノードへの CAS だけで行い、取り出し側は drain で溜まった要素を一度の exchange で
+// まとめて受け取る。取り出しのコストは溜まっていた要素数に比例し、空なら atomic 1回で済む。
+// 内部では後入れ先出しのリストになっているので、drain で反転して push された順に渡す。
+template <typename T>
+class MpscQueue
+{
+public:
+    MpscQueue() : m_head(nullptr) {}
+    ~MpscQueue()
+    {
+        Node *node = m_head.load(std::memory_order_acquire);
+        while (node)
+        {
+            Node *next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    MpscQueue(const MpscQueue &) = delete;
+    MpscQueue &operator=(const MpscQueue &) = delete;
+
+    // 任意のスレッドから呼べる
+    void push(T value)
+    {
+        Node *node = new Node{std::move(value), m_head.load(std::memory_order_relaxed)};
+        while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release,
+                                             std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // 溜まっている要素を push された順に func(T &&) へ渡し、渡した数を返す
+    // 取り出し側のスレッドからのみ呼ぶこと (drain 中に push された要素は次回に回る)
+    template <typename Func>
+    size_t drain(Func &&func)
+    {
+        Node *node = m_head.exchange(nullptr, std::memory_order_acquire);
+
+        Node *ordered = nullptr;
+        while (node)
+        {
+            Node *next = node->next;
+            node->next = ordered;
+            ordered = node;
+            node = next;
+        }
+
+        size_t count = 0;
+        while (ordered)
+        {
+            std::unique_ptr<Node> current(ordered);
+            ordered = ordered->next;
+            func(std::move(current->value));
+            ++count;
+        }
+        return count;
+    }
+
+private:
+    struct Node
+    {
+        T value;
+        Node *next;
+    };
+
+    std::atomic<Node *> m_head;
+};
+
+#endif // MPSC_QUEUE_HPP
@@ -0,0 +1,137 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+namespace
+{
+    // 現在のスレッドがどのプールの何番目のワーカーか (ワーカー以外は nullptr)
+    thread_local const ThreadPool *t_currentPool = nullptr;
+    thread_local size_t t_workerIndex = 0;
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : m_pendingJobs(0), m_nextQueue(0), m_stopping(false)
+{
+    if (threadCount == 0)
+    {
+        size_t hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = std::max<size_t>(1, hardwareThreads > 1 ? hardwareThreads - 1 : 1);
+    }
+
+    m_queues.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+// 停止を知らせてから各キューを空にする (ワーカーは停止を確認した後は新しいジョブを取らない)
+// 破棄するジョブが保持しているもの (チャンクなど) は、キューのロックの外で解放する
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping = true;
+    }
+    m_wakeCondition.notify_all();
+    for (std::unique_ptr<WorkQueue> &queue : m_queues)
+    {
+        std::deque<Job> discarded;
+        {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            discarded.swap(queue->jobs);
+            m_pendingJobs.fetch_sub(discarded.size(), std::memory_order_acq_rel);
+        }
+    }
+    for (std::thread &worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::enqueue(Job job)
+{
+    // ワーカー自身が投入したジョブは自分のキューへ、それ以外は順番に各キューへ振り分ける
+    size_t queueIndex = (t_currentPool == this)
+                            ? t_workerIndex
+                            : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+    {
+        // 件数はキューのロック内で増減させる (件数が 0 でなければ、どこかのキューに必ずジョブがある)
+        std::lock_guard<std::mutex> queueLock(m_queues[queueIndex]->mutex);
+        m_queues[queueIndex]->jobs.push_back(std::move(job));
+        // 待機中のワーカーが通知を取りこぼさないよう、スリープ用ミューテックスも取ってから件数を増やす
+        std::lock_guard<std::mutex> sleepLock(m_sleepMutex);
+        m_pendingJobs.fetch_add(1, std::memory_order_release);
+    }
+    m_wakeCondition.notify_one();
+}
+
+void ThreadPool::workerLoop(size_t workerIndex)
+{
+    t_currentPool = this;
+    t_workerIndex = workerIndex;
+
+    while (!m_stopping.load(std::memory_order_acquire))
+    {
+        Job job;
+        // 他のワーカーが使用中のキューはまず飛ばし、見つからなければロックを待って全て確認する
+        // (件数が残っているのにジョブを見つけられないまま待機に戻ると、待機条件が成立したまま空回りする)
+        if (popLocalJob(workerIndex, job) || stealJob(workerIndex, job, false) || stealJob(workerIndex, job, true))
+        {
+            job();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wakeCondition.wait(lock, [this]()
+                             { return m_stopping || m_pendingJobs.load(std::memory_order_acquire) > 0; });
+    }
+}
+
+// 自分のキューは末尾 (最後に積んだもの) から取り出す
+bool ThreadPool::popLocalJob(size_t workerIndex, Job &job)
+{
+    WorkQueue &queue = *m_queues[workerIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty())
+    {
+        return false;
+    }
+    job = std::move(queue.jobs.back());
+    queue.jobs.pop_back();
+    m_pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+// 他のワーカーのキューは先頭 (最も古いもの) から盗む
+// blocking が false ならロックを取れないキューは飛ばす
+bool ThreadPool::stealJob(size_t thiefIndex, Job &job, bool blocking)
+{
+    const size_t queueCount = m_queues.size();
+    for (size_t offset = 1; offset < queueCount; ++offset)
+    {
+        WorkQueue &queue = *m_queues[(thiefIndex + offset) % queueCount];
+        std::unique_lock<std::mutex> lock(queue.mutex, std::defer_lock);
+        if (blocking)
+        {
+            lock.lock();
+        }
+        else if (!lock.try_lock())
+        {
+            continue;
+        }
+        if (queue.jobs.empty())
+        {
+            continue;
+        }
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+        m_pendingJobs.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+    return false;
+}
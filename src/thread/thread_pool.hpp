@@ -0,0 +1,62 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定数のワーカースレッドでジョブを実行するスレッドプール
+// ワーカーごとにジョブの両端キューを持ち、自分のキューは末尾から取り出し、
+// 空になったら他のワーカーのキューの先頭からジョブを盗む (ワークスティーリング)。
+// ジョブごとにスレッドを生成しないため、大量のジョブを投入してもスレッド数は一定に保たれる。
+class ThreadPool
+{
+public:
+    // threadCount が 0 の場合はハードウェアの並列数から描画スレッドの分を除いた数にする
+    explicit ThreadPool(size_t threadCount = 0);
+    // 実行中のジョブの完了は待つが、まだ始まっていないジョブは実行せずに破棄する
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // ジョブを投入する (完了の通知が必要ならジョブ自身で行う)
+    template <typename F>
+    void execute(F &&func)
+    {
+        enqueue(Job(std::forward<F>(func)));
+    }
+
+    size_t getThreadCount() const { return m_workers.size(); }
+
+private:
+    using Job = std::function<void()>;
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::atomic<size_t> m_pendingJobs; // キューに積まれているジョブの数 (積んだキューのロック内で増減する)
+    std::atomic<size_t> m_nextQueue; // 外部スレッドからの投入先 (ラウンドロビン)
+    std::atomic<bool> m_stopping;
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeCondition;
+
+    void enqueue(Job job);
+    void workerLoop(size_t workerIndex);
+    bool popLocalJob(size_t workerIndex, Job &job);
+    bool stealJob(size_t thiefIndex, Job &job, bool blocking);
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,41 @@
+#include "frame_budget.hpp"
+#include <algorithm>
+
+namespace
+{
+    // 移動平均の更新率 (大きいほど直近の値に素早く追従する)
+    constexpr double FRAME_TIME_SMOOTHING = 0.1;
+    constexpr double WORK_COST_SMOOTHING = 0.2;
+    // 目標との差のうち、1フレームで予算に反映する割合
+    constexpr double BUDGET_ADAPT_RATE = 0.25;
+}
+
+FrameBudget::FrameBudget(double targetFrameSeconds, double minBudgetSeconds, double maxBudgetSeconds)
+    : m_targetFrameSeconds(targetFrameSeconds),
+      m_minBudgetSeconds(minBudgetSeconds),
+      m_maxBudgetSeconds(maxBudgetSeconds),
+      m_averageWorkSeconds(targetFrameSeconds),
+      m_budgetSeconds(minBudgetSeconds),
+      m_frameStart(Clock::now()) {}
+
+void FrameBudget::beginFrame(double lastFrameWorkSeconds) {
+    if (lastFrameWorkSeconds > 0.0) {
+        m_averageWorkSeconds += (lastFrameWorkSeconds - m_averageWorkSeconds) * FRAME_TIME_SMOOTHING;
+        // 作業時間には予算で行った作業も含まれるので、フレームが目標の時間で埋まったところで落ち着く
+        double slack = m_targetFrameSeconds - m_averageWorkSeconds;
+        m_budgetSeconds = std::clamp(m_budgetSeconds + slack * BUDGET_ADAPT_RATE,
+                                     m_minBudgetSeconds, m_maxBudgetSeconds);
+    }
+    m_frameStart = Clock::now();
+}
+
+double FrameBudget::getElapsedSeconds() const {
+    return std::chrono::duration<double>(Clock::now() - m_frameStart).count();
+}
+
+void WorkCostEstimate::record(double units, double seconds) {
+    if (units <= 0.0) {
+        return;
+    }
+    m_secondsPerUnit += (seconds / units - m_secondsPerUnit) * WORK_COST_SMOOTHING;
+}
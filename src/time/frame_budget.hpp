@@ -0,0 +1,42 @@
+#ifndef FRAME_BUDGET_HPP
+#define FRAME_BUDGET_HPP
+
+#include <chrono>
+
+// メインスレッドで1フレームに行う追加作業 (GPU への転送、リソースの削除など) の時間予算
+// 直近のフレームの作業時間の平均が目標のフレーム時間より短ければ余っている分だけ予算を増やし、長ければ減らす。
+// 作業時間には垂直同期の待ちを含めないこと (含めると目標に張り付き、余裕があっても予算が増えない)。
+class FrameBudget {
+public:
+    FrameBudget(double targetFrameSeconds, double minBudgetSeconds, double maxBudgetSeconds);
+
+    // 作業を始める前に毎フレーム呼ぶ。直前のフレームの作業時間 (0 以下なら無視) から予算を調整し、計測を始める
+    void beginFrame(double lastFrameWorkSeconds);
+    // beginFrame からの経過時間
+    double getElapsedSeconds() const;
+    // estimatedSeconds かかる作業が予算内に収まるか
+    bool canAfford(double estimatedSeconds) const { return getElapsedSeconds() + estimatedSeconds <= m_budgetSeconds; }
+    double getRemainingSeconds() const { return m_budgetSeconds - getElapsedSeconds(); }
+    double getBudgetSeconds() const { return m_budgetSeconds; }
+private:
+    using Clock = std::chrono::steady_clock;
+
+    double m_targetFrameSeconds, m_minBudgetSeconds, m_maxBudgetSeconds;
+    double m_averageWorkSeconds; // フレームの作業時間の指数移動平均
+    double m_budgetSeconds;
+    Clock::time_point m_frameStart;
+};
+
+// 作業1単位 (頂点1つ、バッファ1つなど) あたりの所要時間の移動平均
+// 実際に計測した時間で更新し、次の作業が予算に収まるかの見積もりに使う
+class WorkCostEstimate {
+public:
+    explicit WorkCostEstimate(double initialSecondsPerUnit) : m_secondsPerUnit(initialSecondsPerUnit) {}
+
+    double estimate(double units) const { return m_secondsPerUnit * units; }
+    void record(double units, double seconds);
+private:
+    double m_secondsPerUnit;
+};
+
+#endif // FRAME_BUDGET_HPP
@@ -1,78 +1,48 @@
 #include "voxel_accessor.hpp"
 
-VoxelAccessor::VoxelAccessor(const Chunk& currentChunk,
-                             const Chunk* neighbor_neg_x, const Chunk* neighbor_pos_x,
-                             const Chunk* neighbor_neg_y, const Chunk* neighbor_pos_y,
-                             const Chunk* neighbor_neg_z, const Chunk* neighbor_pos_z)
-    : currentChunk_(currentChunk),
-      neighbor_neg_x_(neighbor_neg_x), neighbor_pos_x_(neighbor_pos_x),
-      neighbor_neg_y_(neighbor_neg_y), neighbor_pos_y_(neighbor_pos_y),
-      neighbor_neg_z_(neighbor_neg_z), neighbor_pos_z_(neighbor_pos_z),
-      chunkSize_(currentChunk.getSize())
+VoxelAccessor::VoxelAccessor(const Chunk& currentChunk, const ChunkNeighborhood& neighbors)
+    : chunkSize_(currentChunk.getSize()),
+      paddedSize_(currentChunk.getSize() + 2)
 {
-}
-
-size_t VoxelAccessor::getLocalVoxelIndex(int x, int y, int z) const
-{
-    // 範囲チェックは呼び出し元で行われるか、結果を使用する側で考慮されることを前提
-    // ここでは単純なインデックス計算のみ
-    return static_cast<size_t>(x + y * chunkSize_ + z * chunkSize_ * chunkSize_);
-}
+    // Chunk の構築時にサイズを MAX_SIZE 以下に制限しているので、パディング付きの列は必ず1ワードに収まる
+    static_assert(Chunk::MAX_SIZE + 2 <= 64, "Padded column must fit in 64 bits.");
+    paddedColumns_.resize(static_cast<size_t>(paddedSize_) * paddedSize_);
 
-bool VoxelAccessor::isSolid(int x, int y, int z) const
-{
-    if (x >= 0 && x < chunkSize_ &&
-        y >= 0 && y < chunkSize_ &&
-        z >= 0 && z < chunkSize_)
+    // 範囲外の座標を (隣接チャンクの方向, そのチャンク内の座標) に分解する
+    auto split = [this](int coord, int &offset, int &local)
     {
-        // 現在のチャンク内のボクセル
-        return currentChunk_.getVoxels()[getLocalVoxelIndex(x, y, z)];
-    }
-    else // 隣接チャンクのボクセル
-    {
-        const Chunk *targetChunk = nullptr;
-        int targetX = x;
-        int targetY = y;
-        int targetZ = z;
+        offset = (coord < 0) ? -1 : (coord >= chunkSize_ ? 1 : 0);
+        local = coord - offset * chunkSize_;
+    };
 
-        if (x < 0)
-        {
-            targetChunk = neighbor_neg_x_;
-            targetX = chunkSize_ + x;
-        }
-        else if (x >= chunkSize_)
-        {
-            targetChunk = neighbor_pos_x_;
-            targetX = x - chunkSize_;
-        }
-        else if (y < 0)
-        {
-            targetChunk = neighbor_neg_y_;
-            targetY = chunkSize_ + y;
-        }
-        else if (y >= chunkSize_)
-        {
-            targetChunk = neighbor_pos_y_;
-            targetY = y - chunkSize_;
-        }
-        else if (z < 0)
-        {
-            targetChunk = neighbor_neg_z_;
-            targetZ = chunkSize_ + z;
-        }
-        else if (z >= chunkSize_)
+    for (int z = -1; z <= chunkSize_; ++z)
+    {
+        int dz, localZ;
+        split(z, dz, localZ);
+        for (int x = -1; x <= chunkSize_; ++x)
         {
-            targetChunk = neighbor_pos_z_;
-            targetZ = z - chunkSize_;
-        }
+            int dx, localX;
+            split(x, dx, localX);
 
-        if (targetChunk != nullptr &&
-            targetX >= 0 && targetX < chunkSize_ &&
-            targetY >= 0 && targetY < chunkSize_ &&
-            targetZ >= 0 && targetZ < chunkSize_)
-        {
-            return targetChunk->getVoxels()[getLocalVoxelIndex(targetX, targetY, targetZ)];
+            const Chunk *below = neighbors[chunkNeighborhoodIndex(dx, -1, dz)];
+            const Chunk *middle = (dx == 0 && dz == 0) ? &currentChunk
+                                                       : neighbors[chunkNeighborhoodIndex(dx, 0, dz)];
+            const Chunk *above = neighbors[chunkNeighborhoodIndex(dx, 1, dz)];
+
+            Chunk::Column column = 0;
+            if (middle)
+            {
+                column |= middle->getColumn(localX, localZ) << 1;
+            }
+            if (below)
+            {
+                column |= (below->getColumn(localX, localZ) >> (chunkSize_ - 1)) & 1;
+            }
+            if (above)
+            {
+                column |= (above->getColumn(localX, localZ) & 1) << (chunkSize_ + 1);
+            }
+            paddedColumns_[getPaddedColumnIndex(x, z)] = column;
         }
     }
-    return false; // 範囲外またはチャンクが存在しない場合はソリッドではないとみなす
-}
\ No newline at end of file
+}
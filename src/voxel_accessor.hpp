@@ -2,32 +2,58 @@
 #define VOXEL_ACCESSOR_HPP
 
 #include "chunk/chunk.hpp" // Chunkクラスの定義のため
+#include <array>
 #include <vector>
-#include <limits> // std::numeric_limits のために追加
+#include <glm/glm.hpp>
 
+// 自身と 26 近傍のチャンク (3x3x3) へのポインタ。存在しないチャンクは nullptr
+// インデックスは chunkNeighborhoodIndex で求める (中央 13 が自身)
+using ChunkNeighborhood = std::array<const Chunk *, 27>;
+
+inline int chunkNeighborhoodIndex(int dx, int dy, int dz)
+{
+    return (dx + 1) + (dy + 1) * 3 + (dz + 1) * 9;
+}
+
+inline int chunkNeighborhoodIndex(const glm::ivec3 &offset)
+{
+    return chunkNeighborhoodIndex(offset.x, offset.y, offset.z);
+}
+
+// メッシュ生成用のボクセルスナップショット
+// チャンクとその 26 近傍から、周囲 1 ボクセル分のハローを含む (size+2)^3 の占有情報を
+// 構築時に一度だけコピーする。各 (x, z) 列は 1 つの 64bit ワードで、ビット y+1 が
+// ボクセル (x, y, z) に対応する。以降の参照は分岐なしのフラットなインデックス計算のみ。
 class VoxelAccessor
 {
 public:
-    VoxelAccessor(const Chunk& currentChunk,
-                  const Chunk* neighbor_neg_x, const Chunk* neighbor_pos_x,
-                  const Chunk* neighbor_neg_y, const Chunk* neighbor_pos_y,
-                  const Chunk* neighbor_neg_z, const Chunk* neighbor_pos_z);
+    VoxelAccessor(const Chunk& currentChunk, const ChunkNeighborhood& neighbors);
+
+    // チャンクローカル座標 (-1〜size の範囲) のボクセルがソリッドかどうか
+    // 存在しない隣接チャンクのボクセルはソリッドではないとみなす
+    bool isSolid(int x, int y, int z) const
+    {
+        return (paddedColumns_[getPaddedColumnIndex(x, z)] >> (y + 1)) & 1;
+    }
+
+    // (x, z) 列のハロー付きソリッドマスク (x, z は -1〜size)
+    // ビット 0 が y = -1、ビット size+1 が y = size に対応する
+    Chunk::Column getPaddedColumn(int x, int z) const
+    {
+        return paddedColumns_[getPaddedColumnIndex(x, z)];
+    }
 
-    // 指定されたワールド座標でのボクセルがソリッドかどうかを判断
-    bool isSolid(int x, int y, int z) const;
+    int getChunkSize() const { return chunkSize_; }
 
 private:
-    const Chunk& currentChunk_;
-    const Chunk* neighbor_neg_x_;
-    const Chunk* neighbor_pos_x_;
-    const Chunk* neighbor_neg_y_;
-    const Chunk* neighbor_pos_y_;
-    const Chunk* neighbor_neg_z_;
-    const Chunk* neighbor_pos_z_;
     int chunkSize_;
+    int paddedSize_;
+    std::vector<Chunk::Column> paddedColumns_;
 
-    // チャンク内のローカルボクセルインデックスを取得
-    size_t getLocalVoxelIndex(int x, int y, int z) const;
+    size_t getPaddedColumnIndex(int x, int z) const
+    {
+        return static_cast<size_t>((x + 1) + (z + 1) * paddedSize_);
+    }
 };
 
 #endif // VOXEL_ACCESSOR_HPP
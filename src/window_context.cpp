@@ -32,13 +32,22 @@ bool WindowContext::initialize() {
     std::cout << "GLFW initialized.\n";
 
     // ウィンドウヒントの設定
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
     glfwWindowHint(GLFW_SAMPLES, 4); // MSAA (マルチサンプルアンチエイリアシング)
 
     // ウィンドウの作成とOpenGLコンテキストの生成
-    m_window.reset(glfwCreateWindow(m_width, m_height, m_title.c_str(), NULL, NULL));
+    // チャンクの一括描画 (glMultiDrawElementsIndirect) のためにまず 4.3 を要求し、
+    // 作成できなければ 3.3 で作り直す (その場合 ChunkRenderer は 3.3 の描画経路を使う)
+    const int contextVersions[][2] = {{4, 3}, {3, 3}};
+    for (const auto& version : contextVersions) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, version[0]);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, version[1]);
+        m_window.reset(glfwCreateWindow(m_width, m_height, m_title.c_str(), NULL, NULL));
+        if (m_window) {
+            std::cout << "OpenGL " << version[0] << "." << version[1] << " core context requested.\n";
+            break;
+        }
+    }
     if (!m_window) {
         std::cerr << "Failed to create GLFW window\n";
         glfwTerminate(); // ウィンドウ作成失敗時はGLFWを終了